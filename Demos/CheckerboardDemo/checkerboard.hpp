@@ -0,0 +1,599 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <array>
+#include <utility>
+
+using identity = int;
+
+template <typename T>
+struct range_t {
+	T begin, end;
+
+	range_t() = default;
+
+	range_t(const T& begin, const T& end) : begin(begin), end(end) {}
+
+	T length() const noexcept { return end - begin; }
+};
+
+template <typename T>
+struct point_t {
+	T x, y;
+
+	point_t() = default;
+
+	point_t(const T& x, const T& y) : x(x), y(y) {}
+};
+
+using range = range_t<int>;
+using point = point_t<int>;
+
+// interleave the bits of x and y(x is the lower bit), the cells of an aligned square of size 2^j are contiguous
+inline int morton_encode(int x, int y) {
+	const auto spread = [](std::uint32_t value) {
+		value = (value | (value << 8)) & 0x00FF00FF;
+		value = (value | (value << 4)) & 0x0F0F0F0F;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+
+		return value;
+	};
+
+	return static_cast<int>(spread(static_cast<std::uint32_t>(x)) | (spread(static_cast<std::uint32_t>(y)) << 1));
+}
+
+inline point morton_decode(int index) {
+	const auto compact = [](std::uint32_t value) {
+		value = value & 0x55555555;
+		value = (value | (value >> 1)) & 0x33333333;
+		value = (value | (value >> 2)) & 0x0F0F0F0F;
+		value = (value | (value >> 4)) & 0x00FF00FF;
+		value = (value | (value >> 8)) & 0x0000FFFF;
+
+		return static_cast<int>(value);
+	};
+
+	return point(compact(static_cast<std::uint32_t>(index)), compact(static_cast<std::uint32_t>(index) >> 1));
+}
+
+/*
+ * checkerboard of 2^k * 2^k cells without one cell, tiled by L-trominoes(blocks)
+ * the blocks are colored with 3 colors so that adjacent blocks have different colors.
+ * coloring : DSatur, the block with most distinct colors of neighbors is colored first(ties are broken
+ * by the number of uncolored neighbors), it is O(blocks) since a block has a few neighbors.
+ * the backtracking over block ids is only the fallback when DSatur can not finish with 3 colors.
+ * layout : the cells are stored in Morton order, the tiling walks the squares depth first with an explicit stack
+ * so every square is written into a contiguous range of cells, a block is the indices of its 3 cells.
+ * parallel : a square of size 2^j has (4^j - 1) / 3 blocks, so the first id of every quadrant is known before
+ * the quadrants before it are tiled. the top levels are split on the calling thread, then the squares are
+ * tiled by a pool of threads, the ids are the same as the serial tiling.
+ * graph : the neighbors of blocks are in CSR form, the neighbors of block are neighbors[offsets[block], offsets[block + 1])
+ */
+
+class checkerboard {
+public:
+	static constexpr identity color_count = 3;
+
+	explicit checkerboard(int k);
+
+	~checkerboard() = default;
+
+	// threads = 0 means all hardware threads, small boards are tiled on the calling thread
+	void build(int x, int y, size_t threads = 0);
+
+	// the stages of build in order, they are separated so the cost of each stage can be measured
+	void build_tiles(int x, int y, size_t threads = 0);
+
+	void build_graph();
+
+	void build_colors();
+
+	identity color(int x, int y) const;
+
+	identity id(int x, int y) const;
+
+	int size() const noexcept;
+
+	// the number of blocks after build_tiles
+	auto block_count() const noexcept -> size_t;
+private:
+	struct square {
+		int x, y, size;
+
+		// the cell that is not covered by the blocks in square
+		int missing_x, missing_y;
+
+		// the id of the block at the center of square, the blocks of quadrants follow it in pre-order
+		identity id;
+	};
+
+	// tile the board without cell (x, y), the ids of blocks are in pre-order of the squares
+	void push_triangles(int x, int y, size_t threads);
+
+	void push_square(const square& root);
+
+	// write the block at the center of square and return the quadrants(the square should be larger than 2 * 2)
+	auto push_center(const square& current) -> std::array<square, 4>;
+
+	void push_graph();
+
+	// the sorted distinct neighbors of block, a block has at most 3 * 4 neighbors
+	auto collect_neighbors(identity block, std::array<identity, 12>& neighbors) const -> size_t;
+
+	auto neighbors(identity block) const -> range_t<const identity*>;
+
+	bool push_colors();
+
+	// color the blocks in the order of ids, return false if there is no coloring with color_count colors
+	bool push_colors_backtracking();
+
+	bool check(identity block, identity color) const;
+
+	int block_index(int x, int y) const;
+
+	std::vector<identity> mIdentity;
+	std::vector<identity> mColors;
+	std::vector<std::array<int, 3>> mBlocks;
+
+	std::vector<int> mOffsets;
+	std::vector<identity> mNeighbors;
+	std::vector<identity> mBlockColors;
+
+	int mSize;
+};
+
+inline checkerboard::checkerboard(int k)
+{
+	// the index of cell should fit in int
+	assert(k > 0 && k < 16);
+
+	mSize = 1 << k;
+}
+
+inline void checkerboard::build(int x, int y, size_t threads)
+{
+	build_tiles(x, y, threads);
+	build_graph();
+	build_colors();
+}
+
+inline void checkerboard::build_tiles(int x, int y, size_t threads)
+{
+	mIdentity = std::vector<identity>(mSize * mSize, 0);
+	mBlocks = std::vector<std::array<int, 3>>((mSize * mSize - 1) / 3 + 1);
+
+	push_triangles(x, y, threads);
+}
+
+inline void checkerboard::build_graph()
+{
+	push_graph();
+}
+
+inline void checkerboard::build_colors()
+{
+	mColors = std::vector<identity>(mSize * mSize, -1);
+	mBlockColors = std::vector<identity>(mBlocks.size(), -1);
+
+	if (!push_colors()) push_colors_backtracking();
+
+	for (size_t index = 0; index < mColors.size(); index++) {
+		mColors[index] = mBlockColors[mIdentity[index]];
+	}
+}
+
+inline identity checkerboard::color(int x, int y) const
+{
+	return mColors[block_index(x, y)];
+}
+
+inline identity checkerboard::id(int x, int y) const
+{
+	return mIdentity[block_index(x, y)];
+}
+
+inline int checkerboard::size() const noexcept
+{
+	return mSize;
+}
+
+inline auto checkerboard::block_count() const noexcept -> size_t
+{
+	return mBlocks.empty() ? 0 : mBlocks.size() - 1;
+}
+
+inline void checkerboard::push_triangles(int x, int y, size_t threads)
+{
+	if (threads == 0) threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+	const square root = { 0, 0, mSize, x, y, 1 };
+
+	if (threads == 1 || mSize < 256) {
+		push_square(root);
+
+		return;
+	}
+
+	// split the levels until there are enough squares for the threads to balance
+	std::vector<square> squares = { root };
+
+	while (squares.size() < threads * 16 && squares.front().size > 2) {
+		std::vector<square> quadrants;
+
+		for (const auto& current : squares) {
+			const auto next = push_center(current);
+
+			quadrants.insert(quadrants.end(), next.begin(), next.end());
+		}
+
+		squares = std::move(quadrants);
+	}
+
+	// the squares are disjoint, so are their cells and ids
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+
+	for (size_t index = 0; index < threads; index++) {
+		workers.push_back(std::thread([&]() {
+			for (auto current = next++; current < squares.size(); current = next++)
+				push_square(squares[current]);
+		}));
+	}
+
+	for (auto& worker : workers) worker.join();
+}
+
+inline void checkerboard::push_square(const square& root)
+{
+	// the quadrants are pushed in reverse order, so they are popped in the order of recursion
+	std::vector<square> stack = { root };
+
+	while (!stack.empty()) {
+		const auto current = stack.back();
+
+		stack.pop_back();
+
+		const auto quadrants = push_center(current);
+
+		if (current.size == 2) continue;
+
+		stack.insert(stack.end(), quadrants.rbegin(), quadrants.rend());
+	}
+}
+
+inline auto checkerboard::push_center(const square& current) -> std::array<square, 4>
+{
+	const auto half = current.size / 2;
+	const auto center_x = current.x + half;
+	const auto center_y = current.y + half;
+
+	auto x_offset = 0;
+	auto y_offset = 0;
+
+	if (current.missing_x < center_x) x_offset = 1;
+	if (current.missing_y < center_y) y_offset = 1;
+
+	// the block is the center 2 * 2 cells without the one in the quadrant of missing cell
+	// for a square of 2 * 2 cells, it is the square without the missing cell
+	auto cell = 0;
+
+	for (auto offset_x = 0; offset_x < 2; offset_x++) {
+		for (auto offset_y = 0; offset_y < 2; offset_y++) {
+			if (offset_x == x_offset && offset_y == y_offset) continue;
+
+			const auto index = block_index(center_x - offset_x, center_y - offset_y);
+
+			mIdentity[index] = current.id;
+			mBlocks[current.id][cell++] = index;
+		}
+	}
+
+	std::array<square, 4> quadrants;
+
+	// the number of blocks in a quadrant
+	const auto blocks = (half * half - 1) / 3;
+
+	for (auto index = 0; index < 4; index++) {
+		const auto high_x = index / 2;
+		const auto high_y = index % 2;
+
+		quadrants[index] = {
+			current.x + high_x * half, current.y + high_y * half, half,
+			center_x - 1 + high_x, center_y - 1 + high_y,
+			current.id + 1 + index * blocks
+		};
+
+		if ((1 - x_offset) == high_x && (1 - y_offset) == high_y) {
+			quadrants[index].missing_x = current.missing_x;
+			quadrants[index].missing_y = current.missing_y;
+		}
+	}
+
+	return quadrants;
+}
+
+inline void checkerboard::push_graph()
+{
+	std::array<identity, 12> neighbors;
+
+	// count the neighbors, then fill them in the second pass
+	mOffsets = std::vector<int>(mBlocks.size() + 1, 0);
+
+	for (identity block = 1; block < static_cast<identity>(mBlocks.size()); block++)
+		mOffsets[block + 1] = mOffsets[block] + static_cast<int>(collect_neighbors(block, neighbors));
+
+	mNeighbors = std::vector<identity>(mOffsets.back());
+
+	for (identity block = 1; block < static_cast<identity>(mBlocks.size()); block++) {
+		const auto count = collect_neighbors(block, neighbors);
+
+		std::copy(neighbors.begin(), neighbors.begin() + count, mNeighbors.begin() + mOffsets[block]);
+	}
+}
+
+inline auto checkerboard::collect_neighbors(identity block, std::array<identity, 12>& neighbors) const -> size_t
+{
+	std::array<int, 4> x_offset = { 0, 0, 1, -1 };
+	std::array<int, 4> y_offset = { 1, -1, 0, 0 };
+
+	size_t count = 0;
+
+	for (const auto& cell : mBlocks[block]) {
+		const auto point = morton_decode(cell);
+
+		for (size_t index = 0; index < 4; index++) {
+			const auto new_x = point.x + x_offset[index];
+			const auto new_y = point.y + y_offset[index];
+
+			if (new_x < 0 || new_x >= mSize) continue;
+			if (new_y < 0 || new_y >= mSize) continue;
+
+			const auto next = mIdentity[block_index(new_x, new_y)];
+
+			if (next == block || next == 0) continue;
+
+			neighbors[count++] = next;
+		}
+	}
+
+	std::sort(neighbors.begin(), neighbors.begin() + count);
+
+	return static_cast<size_t>(std::unique(neighbors.begin(), neighbors.begin() + count) - neighbors.begin());
+}
+
+inline auto checkerboard::neighbors(identity block) const -> range_t<const identity*>
+{
+	return range_t<const identity*>(mNeighbors.data() + mOffsets[block], mNeighbors.data() + mOffsets[block + 1]);
+}
+
+inline bool checkerboard::push_colors()
+{
+	const auto blocks = static_cast<identity>(mBlocks.size());
+
+	size_t max_degree = 0;
+
+	for (identity block = 1; block < blocks; block++)
+		max_degree = std::max(max_degree, static_cast<size_t>(mOffsets[block + 1] - mOffsets[block]));
+
+	// the uncolored neighbors and the mask of colors of neighbors
+	std::vector<int> degree(blocks, 0);
+	std::vector<int> saturation(blocks, 0);
+	std::vector<unsigned> masks(blocks, 0);
+
+	// bucket queue on the key (saturation, degree), the blocks are pushed again when their keys change
+	// so an entry is out of date if the block is colored or its key is changed
+	const auto key = [&](identity block) { return saturation[block] * (max_degree + 1) + degree[block]; };
+
+	std::vector<std::vector<identity>> buckets((color_count + 1) * (max_degree + 1));
+
+	for (identity block = blocks - 1; block >= 1; block--) {
+		degree[block] = mOffsets[block + 1] - mOffsets[block];
+
+		buckets[key(block)].push_back(block);
+	}
+
+	size_t top = buckets.size() - 1;
+
+	for (identity colored = 1; colored < blocks;) {
+		while (buckets[top].empty()) top--;
+
+		const auto block = buckets[top].back();
+
+		buckets[top].pop_back();
+
+		if (mBlockColors[block] != -1 || key(block) != top) continue;
+
+		identity color = 0;
+
+		while (color < color_count && (masks[block] & (1u << color)) != 0) color++;
+
+		if (color == color_count) {
+			mBlockColors.assign(mBlockColors.size(), -1);
+
+			return false;
+		}
+
+		mBlockColors[block] = color;
+		colored++;
+
+		// the blocks near the last colored block are usually popped next since the buckets are stacks
+		const auto span = neighbors(block);
+
+		for (auto neighbor = span.begin; neighbor != span.end; neighbor++) {
+			const auto next = *neighbor;
+
+			if (mBlockColors[next] != -1) continue;
+
+			degree[next]--;
+
+			if ((masks[next] & (1u << color)) == 0) {
+				masks[next] |= 1u << color;
+				saturation[next]++;
+			}
+
+			top = std::max(top, key(next));
+
+			buckets[key(next)].push_back(next);
+		}
+	}
+
+	return true;
+}
+
+inline bool checkerboard::push_colors_backtracking()
+{
+	const auto blocks = static_cast<identity>(mBlocks.size());
+
+	// explicit stack of the blocks in order of ids, the block goes back when it has no color left
+	identity block = 1;
+
+	while (block >= 1 && block < blocks) {
+		auto color = mBlockColors[block] + 1;
+
+		while (color < color_count && !check(block, color)) color++;
+
+		if (color < color_count) {
+			mBlockColors[block] = color;
+			block++;
+		}
+		else {
+			mBlockColors[block] = -1;
+			block--;
+		}
+	}
+
+	return block == blocks;
+}
+
+inline bool checkerboard::check(identity block, identity color) const
+{
+	const auto span = neighbors(block);
+
+	for (auto neighbor = span.begin; neighbor != span.end; neighbor++)
+		if (mBlockColors[*neighbor] == color) return false;
+
+	return true;
+}
+
+
+inline int checkerboard::block_index(int x, int y) const
+{
+	return morton_encode(x, y);
+}
+
+/*
+ * queries of one cell of checkerboard without building the board, each query walks the squares from the board
+ * to the cell in O(k), so the board can be far larger than the memory(k <= 30).
+ * id : the same id as checkerboard::id, the ids of the quadrants of a square are known in closed form
+ * color : a block is either the leaf block of an aligned 2 * 2 square, or the center block of a larger square.
+ * the leaf blocks are only adjacent to the leaf blocks of the 2 * 2 squares that share an edge with them, so they
+ * are colored by the parity of their 2 * 2 square. the center blocks are never adjacent to each other(the
+ * centers of two squares differ by at least 2 in both x and y), so they all get the third color.
+ * it is a valid coloring with 3 colors, but it is not the same coloring as checkerboard::color.
+ */
+
+class checkerboard_query {
+public:
+	// the board of 2^k * 2^k cells without cell (x, y)
+	checkerboard_query(int k, int x, int y);
+
+	// the id of block that covers cell (x, y), 0 for the missing cell
+	auto id(int x, int y) const -> std::int64_t;
+
+	// -1 for the missing cell
+	identity color(int x, int y) const;
+
+	int size() const noexcept;
+private:
+	// the id of block and the size of the square whose center block covers the cell, the size is 0 for the missing cell
+	auto locate(int x, int y) const -> std::pair<std::int64_t, int>;
+
+	int mSize;
+
+	int mMissingX;
+	int mMissingY;
+};
+
+inline checkerboard_query::checkerboard_query(int k, int x, int y) :
+	mMissingX(x), mMissingY(y)
+{
+	assert(k > 0 && k <= 30);
+
+	mSize = 1 << k;
+}
+
+inline auto checkerboard_query::id(int x, int y) const -> std::int64_t
+{
+	return locate(x, y).first;
+}
+
+inline identity checkerboard_query::color(int x, int y) const
+{
+	const auto square_size = locate(x, y).second;
+
+	if (square_size == 0) return -1;
+
+	if (square_size > 2) return 2;
+
+	return ((x >> 1) + (y >> 1)) & 1;
+}
+
+inline int checkerboard_query::size() const noexcept
+{
+	return mSize;
+}
+
+inline auto checkerboard_query::locate(int x, int y) const -> std::pair<std::int64_t, int>
+{
+	assert(x >= 0 && x < mSize && y >= 0 && y < mSize);
+
+	// the same walk as checkerboard::push_center, but only into the quadrant of the cell
+	auto square_x = 0;
+	auto square_y = 0;
+	auto square_size = mSize;
+	auto missing_x = mMissingX;
+	auto missing_y = mMissingY;
+
+	std::int64_t id = 1;
+
+	while (true) {
+		const auto half = square_size / 2;
+		const auto center_x = square_x + half;
+		const auto center_y = square_y + half;
+
+		auto x_offset = 0;
+		auto y_offset = 0;
+
+		if (missing_x < center_x) x_offset = 1;
+		if (missing_y < center_y) y_offset = 1;
+
+		const auto in_center = x >= center_x - 1 && x <= center_x && y >= center_y - 1 && y <= center_y;
+
+		if (in_center && (x != center_x - x_offset || y != center_y - y_offset)) return { id, square_size };
+
+		if (square_size == 2) return { 0, 0 };
+
+		const auto high_x = x < center_x ? 0 : 1;
+		const auto high_y = y < center_y ? 0 : 1;
+
+		// the number of blocks in a quadrant
+		const auto blocks = (static_cast<std::int64_t>(half) * half - 1) / 3;
+
+		id = id + 1 + (high_x * 2 + high_y) * blocks;
+
+		if ((1 - x_offset) != high_x || (1 - y_offset) != high_y) {
+			missing_x = center_x - 1 + high_x;
+			missing_y = center_y - 1 + high_y;
+		}
+
+		square_x = square_x + high_x * half;
+		square_y = square_y + high_y * half;
+		square_size = half;
+	}
+}
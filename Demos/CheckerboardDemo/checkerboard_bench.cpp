@@ -0,0 +1,190 @@
+#include "checkerboard.hpp"
+
+#define BENCH_UNIT "cells"
+#include "../bench_common.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <random>
+
+/*
+ * headless benchmark and export of checkerboard
+ * suite mode builds the boards of k in [min_k, max_k] with the missing cell at the corner, the center and a random
+ * cell, times the tiling, graph and coloring separately and validates the coloring, the small boards are also
+ * compared with checkerboard_query and its coloring is validated.
+ * export mode builds one board and writes prefix.ids(the ids of cells as 32-bit ints in row-major order) and
+ * prefix.ppm(a binary ppm image, one pixel per cell with the colors of CheckerboardDemo, black for the missing cell).
+ */
+
+// the boards of k not greater than it are also checked by checkerboard_query, which walks k squares per cell
+constexpr auto max_query_k = 10;
+
+// the cells of different blocks that share an edge should have different colors, only the missing cell has no color
+// Board is checkerboard or checkerboard_query
+template <typename Board>
+bool validate(const Board& board) {
+	const auto size = board.size();
+
+	for (auto y = 0; y < size; y++) {
+		for (auto x = 0; x < size; x++) {
+			const auto id = board.id(x, y);
+			const auto color = board.color(x, y);
+
+			if (id == 0) {
+				if (color != -1) return false;
+
+				continue;
+			}
+
+			if (color < 0 || color >= checkerboard::color_count) return false;
+
+			if (x + 1 < size && board.id(x + 1, y) != id && board.id(x + 1, y) != 0 && board.color(x + 1, y) == color) return false;
+			if (y + 1 < size && board.id(x, y + 1) != id && board.id(x, y + 1) != 0 && board.color(x, y + 1) == color) return false;
+		}
+	}
+
+	return true;
+}
+
+// checkerboard_query should give every cell the same id as the built board
+bool validate_query(const checkerboard& board, const checkerboard_query& query) {
+	const auto size = board.size();
+
+	for (auto y = 0; y < size; y++) {
+		for (auto x = 0; x < size; x++) {
+			if (query.id(x, y) != board.id(x, y)) return false;
+		}
+	}
+
+	return true;
+}
+
+void bench_board(int k, int x, int y, size_t threads) {
+	checkerboard board(k);
+
+	const auto cells = static_cast<size_t>(board.size()) * board.size();
+	const auto name = "k = " + std::to_string(k) + " (" + std::to_string(x) + ", " + std::to_string(y) + ")";
+
+	report(name + " tiles", cells, time_used([&]() { board.build_tiles(x, y, threads); }));
+	report(name + " graph", cells, time_used([&]() { board.build_graph(); }));
+	report(name + " colors", cells, time_used([&]() { board.build_colors(); }));
+
+	const auto valid = validate(board);
+
+	std::cout << name << " : " << board.block_count() << " blocks, " << (valid ? "valid" : "invalid") << " coloring." << std::endl;
+
+	if (k > max_query_k) return;
+
+	const checkerboard_query query(k, x, y);
+
+	const auto same_ids = validate_query(board, query);
+	const auto valid_query = validate(query);
+
+	std::cout << name << " query : " << (same_ids ? "same" : "different") << " ids, "
+		<< (valid_query ? "valid" : "invalid") << " coloring." << std::endl;
+}
+
+void bench_suite(int min_k, int max_k, size_t threads) {
+	std::mt19937 random(0);
+
+	for (auto k = min_k; k <= max_k; k++) {
+		const auto size = 1 << k;
+
+		bench_board(k, 0, 0, threads);
+		bench_board(k, size / 2, size / 2, threads);
+		bench_board(k, static_cast<int>(random() % size), static_cast<int>(random() % size), threads);
+	}
+}
+
+bool export_board(int k, int x, int y, const std::string& prefix) {
+	checkerboard board(k);
+
+	board.build(x, y);
+
+	if (!validate(board)) {
+		std::cout << "the coloring is invalid." << std::endl;
+
+		return false;
+	}
+
+	const auto size = board.size();
+
+	std::ofstream ids(prefix + ".ids", std::ios::binary);
+	std::ofstream image(prefix + ".ppm", std::ios::binary);
+
+	if (!ids || !image) {
+		std::cout << "can not open the files of " << prefix << "." << std::endl;
+
+		return false;
+	}
+
+	// the same colors as the ColorTable of CheckerboardDemo
+	const unsigned char colors[4][3] = { { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 255, 255, 0 } };
+	const unsigned char missing[3] = { 0, 0, 0 };
+
+	image << "P6\n" << size << " " << size << "\n255\n";
+
+	// one row at a time, the board is stored in Morton order
+	std::vector<std::int32_t> row_ids(size);
+	std::vector<unsigned char> row_pixels(static_cast<size_t>(size) * 3);
+
+	for (auto y_index = 0; y_index < size; y_index++) {
+		for (auto x_index = 0; x_index < size; x_index++) {
+			const auto color = board.color(x_index, y_index);
+			const auto pixel = color == -1 ? missing : colors[color];
+
+			row_ids[x_index] = board.id(x_index, y_index);
+
+			std::copy(pixel, pixel + 3, row_pixels.begin() + x_index * 3);
+		}
+
+		ids.write(reinterpret_cast<const char*>(row_ids.data()), row_ids.size() * sizeof(std::int32_t));
+		image.write(reinterpret_cast<const char*>(row_pixels.data()), row_pixels.size());
+	}
+
+	std::cout << "export " << board.block_count() << " blocks to " << prefix << ".ids and " << prefix << ".ppm." << std::endl;
+
+	return true;
+}
+
+// checkerboard_bench [suite min_k max_k threads] | [export k x y prefix]
+int main(int argc, char** argv) {
+	const std::string mode = argc >= 2 ? argv[1] : "suite";
+
+	if (mode == "export" && argc >= 6) {
+		const auto k = std::stoi(argv[2]);
+		const auto x = std::stoi(argv[3]);
+		const auto y = std::stoi(argv[4]);
+
+		if (k <= 0 || k >= 16 || x < 0 || y < 0 || x >= (1 << k) || y >= (1 << k)) {
+			std::cout << "k should be in [1, 15] and the cell should be in the board." << std::endl;
+
+			return 1;
+		}
+
+		return export_board(k, x, y, argv[5]) ? 0 : 1;
+	}
+
+	if (mode != "suite") {
+		std::cout << "usage : checkerboard_bench [suite min_k max_k threads] | [export k x y prefix]" << std::endl;
+
+		return 1;
+	}
+
+	const auto min_k = argc >= 3 ? std::stoi(argv[2]) : 4;
+	const auto max_k = argc >= 4 ? std::stoi(argv[3]) : 11;
+	const size_t threads = argc >= 5 ? std::stoul(argv[4]) : 0;
+
+	if (min_k <= 0 || max_k >= 16 || min_k > max_k) {
+		std::cout << "the range of k should be in [1, 15]." << std::endl;
+
+		return 1;
+	}
+
+	bench_suite(min_k, max_k, threads);
+
+	return 0;
+}
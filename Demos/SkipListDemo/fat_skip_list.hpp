@@ -0,0 +1,275 @@
+#pragma once
+
+#include "skip_list.hpp"
+
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FAT_SKIP_LIST_SSE2
+#endif
+
+/*
+ * fat skip list is a skip list whose node holds a small sorted array of keys instead of one key
+ * the first key of node is used as the key of node when we walk the levels, so the level 0 walk
+ * touches one node per capacity keys and the last step is a search in one or two cache lines.
+ * when a node is full it is split into two nodes, when two neighbor nodes are small they are merged.
+ */
+
+template<typename Key, typename Value, size_t Capacity>
+struct fat_skip_node {
+	// the slots that are not used are filled with the max key, so the search in node can ignore mCount
+	alignas(64) Key mKeys[Capacity];
+
+	size_t mCount = 0;
+	int mLevel = 0;
+
+	fat_skip_node* mNext[MAX_LEVEL] = {};
+
+	Value mValues[Capacity];
+
+	explicit fat_skip_node(int level) : mLevel(level) {
+		std::fill(mKeys, mKeys + Capacity, std::numeric_limits<Key>::max());
+	}
+
+	// the number of keys in node that less than key
+	auto lower_bound(const Key& key) const -> size_t {
+#ifdef FAT_SKIP_LIST_SSE2
+		if constexpr (std::is_same<Key, int>::value && Capacity % 4 == 0) {
+			const auto target = _mm_set1_epi32(key);
+
+			size_t result = 0;
+
+			for (size_t index = 0; index < Capacity; index += 4) {
+				const auto keys = _mm_load_si128(reinterpret_cast<const __m128i*>(mKeys + index));
+				const auto mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(keys, target)));
+
+				result = result + ((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+			}
+
+			return std::min(result, mCount);
+		}
+#endif
+		size_t result = 0;
+
+		for (size_t index = 0; index < Capacity; index++)
+			result = result + (mKeys[index] < key ? 1 : 0);
+
+		return std::min(result, mCount);
+	}
+};
+
+template<typename Key, typename Value, size_t Capacity = 16>
+class fat_skip_list {
+public:
+	using node_type = fat_skip_node<Key, Value, Capacity>;
+
+	static_assert(Capacity >= 4, "the capacity of node should not be less than 4.");
+public:
+	fat_skip_list() : mHead(new node_type(MAX_LEVEL - 1)), mSize(0) {}
+
+	~fat_skip_list() {
+		while (mHead != nullptr) {
+			const auto next = mHead->mNext[0];
+
+			delete mHead;
+
+			mHead = next;
+		}
+	}
+
+	fat_skip_list(const fat_skip_list&) = delete;
+
+	fat_skip_list& operator=(const fat_skip_list&) = delete;
+
+	// return false if the key is existed, the value will not be changed
+	auto insert(const Key& key, const Value& value) -> bool {
+		node_type* needUpdate[MAX_LEVEL];
+
+		auto node = search(key, needUpdate);
+
+		// the key is less than all keys, so we insert it to the first node
+		if (node == mHead) node = mHead->mNext[0];
+
+		if (node == nullptr) {
+			node = new node_type(random_skip_level());
+
+			for (auto level = node->mLevel; level >= 0; level--) {
+				node->mNext[level] = needUpdate[level]->mNext[level];
+				needUpdate[level]->mNext[level] = node;
+			}
+		}
+
+		auto position = node->lower_bound(key);
+
+		if (position < node->mCount && node->mKeys[position] == key) return false;
+
+		if (node->mCount == Capacity) {
+			const auto newNode = split(node, needUpdate);
+
+			if (position > Capacity / 2) {
+				node = newNode;
+				position = position - Capacity / 2;
+			}
+		}
+
+		for (auto index = node->mCount; index > position; index--) {
+			node->mKeys[index] = node->mKeys[index - 1];
+			node->mValues[index] = std::move(node->mValues[index - 1]);
+		}
+
+		node->mKeys[position] = key;
+		node->mValues[position] = value;
+		node->mCount++;
+
+		mSize++;
+
+		return true;
+	}
+
+	auto erase(const Key& key) -> bool {
+		node_type* needUpdate[MAX_LEVEL];
+
+		const auto node = search(key, needUpdate);
+
+		if (node == mHead) return false;
+
+		const auto position = node->lower_bound(key);
+
+		if (position == node->mCount || node->mKeys[position] != key) return false;
+
+		// the predecessors of node itself, search() gives us the predecessors of key
+		if (position == 0) search_before(key, needUpdate);
+		else search_before(node->mKeys[0], needUpdate);
+
+		for (auto index = position; index + 1 < node->mCount; index++) {
+			node->mKeys[index] = node->mKeys[index + 1];
+			node->mValues[index] = std::move(node->mValues[index + 1]);
+		}
+
+		node->mCount--;
+		node->mKeys[node->mCount] = std::numeric_limits<Key>::max();
+		node->mValues[node->mCount] = Value();
+
+		mSize--;
+
+		if (node->mCount == 0) {
+			for (auto level = node->mLevel; level >= 0; level--)
+				needUpdate[level]->mNext[level] = node->mNext[level];
+
+			delete node;
+
+			return true;
+		}
+
+		const auto next = node->mNext[0];
+
+		if (next != nullptr && node->mCount + next->mCount <= Capacity / 2) merge(node, next, needUpdate);
+
+		return true;
+	}
+
+	// return nullptr if the key is not existed
+	auto find(const Key& key) const -> const Value* {
+		const auto node = search(key);
+
+		if (node == mHead) return nullptr;
+
+		const auto position = node->lower_bound(key);
+
+		if (position == node->mCount || node->mKeys[position] != key) return nullptr;
+
+		return &node->mValues[position];
+	}
+
+	auto min() const -> Key {
+		return mHead->mNext[0]->mKeys[0];
+	}
+
+	auto max() const -> Key {
+		auto node = mHead;
+
+		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
+			while (node->mNext[level] != nullptr) node = node->mNext[level];
+		}
+
+		return node->mKeys[node->mCount - 1];
+	}
+
+	auto size() const noexcept -> size_t { return mSize; }
+
+	auto head() const noexcept -> const node_type* { return mHead; }
+private:
+	// the last node whose first key is not greater than key, mHead if there is no such node
+	auto search(const Key& key, node_type** needUpdate = nullptr) const -> node_type* {
+		auto node = mHead;
+
+		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
+			while (node->mNext[level] != nullptr && !(key < node->mNext[level]->mKeys[0])) node = node->mNext[level];
+
+			if (needUpdate != nullptr) needUpdate[level] = node;
+		}
+
+		return node;
+	}
+
+	// the last nodes whose first key is less than key in each level
+	void search_before(const Key& key, node_type** needUpdate) const {
+		auto node = mHead;
+
+		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
+			while (node->mNext[level] != nullptr && node->mNext[level]->mKeys[0] < key) node = node->mNext[level];
+
+			needUpdate[level] = node;
+		}
+	}
+
+	// move the upper half of node to a new node after it, needUpdate should be the predecessors of any key in node
+	auto split(node_type* node, node_type** needUpdate) -> node_type* {
+		const auto newNode = new node_type(random_skip_level());
+
+		for (auto index = Capacity / 2; index < Capacity; index++) {
+			newNode->mKeys[index - Capacity / 2] = node->mKeys[index];
+			newNode->mValues[index - Capacity / 2] = std::move(node->mValues[index]);
+
+			node->mKeys[index] = std::numeric_limits<Key>::max();
+			node->mValues[index] = Value();
+		}
+
+		newNode->mCount = Capacity - Capacity / 2;
+		node->mCount = Capacity / 2;
+
+		for (auto level = newNode->mLevel; level >= 0; level--) {
+			const auto prev = level <= node->mLevel ? node : needUpdate[level];
+
+			newNode->mNext[level] = prev->mNext[level];
+			prev->mNext[level] = newNode;
+		}
+
+		return newNode;
+	}
+
+	// move all keys of next into node and remove next, needUpdate should be the predecessors of node
+	void merge(node_type* node, node_type* next, node_type** needUpdate) {
+		for (size_t index = 0; index < next->mCount; index++) {
+			node->mKeys[node->mCount + index] = next->mKeys[index];
+			node->mValues[node->mCount + index] = std::move(next->mValues[index]);
+		}
+
+		node->mCount = node->mCount + next->mCount;
+
+		for (auto level = next->mLevel; level >= 0; level--) {
+			const auto prev = level <= node->mLevel ? node : needUpdate[level];
+
+			prev->mNext[level] = next->mNext[level];
+		}
+
+		delete next;
+	}
+private:
+	node_type* mHead;
+
+	size_t mSize;
+};
@@ -130,7 +130,7 @@ void insert_command(
 	}
 
 	// when the key is existed
-	if (list->find(std::stoi(arguments[1])) != "-1") {
+	if (list->contains(std::stoi(arguments[1]))) {
 		console->texts.push_back(
 			purezento::console_text(
 				"error : the key is existed.",
@@ -192,7 +192,7 @@ void erase_command(
 	}
 
 	// when the key is not existed
-	if (list->size() == 0 || list->find(std::stoi(arguments[1])) == "-1") {
+	if (list->size() == 0 || !list->contains(std::stoi(arguments[1]))) {
 		console->texts.push_back(
 			purezento::console_text(
 				"error : the key is not existed.",
@@ -245,7 +245,7 @@ void find_command(
 	}
 
 	// when the key is not existed
-	if (list->size() == 0 || list->find(std::stoi(arguments[1])) == "-1") {
+	if (list->size() == 0 || !list->contains(std::stoi(arguments[1]))) {
 		console->texts.push_back(
 			purezento::console_text(
 				"error : the key is not existed.",
@@ -1,14 +1,55 @@
 #pragma once
 
+#include <cstdint>
+#include <atomic>
 #include <random>
 #include <memory>
+#include <limits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #define MAX_LEVEL 10
 
+// the index of the lowest set bit, value should not be 0
+inline int count_trailing_zeros(std::uint64_t value) {
+#ifdef _MSC_VER
+	unsigned long index = 0;
+
+	_BitScanForward64(&index, value);
+
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+/*
+ * random level generator for skip list
+ * each thread has its own xorshift state, so it is thread-safe without lock.
+ * the number of trailing zeros of a random word is the level, so P(level >= k) = 1 / 2^k.
+ */
+inline auto random_skip_level() -> int {
+	static std::atomic<std::uint64_t> seed(0);
+
+	thread_local std::uint64_t state = 0x9E3779B97F4A7C15ull * (seed.fetch_add(1) + 1);
+
+	state = state ^ (state << 13);
+	state = state ^ (state >> 7);
+	state = state ^ (state << 17);
+
+	// set the bit MAX_LEVEL - 1 to limit the level and avoid the zero word
+	return count_trailing_zeros(state | (1ull << (MAX_LEVEL - 1)));
+}
+
 template<typename Key, typename Value>
 struct skip_node {
 	std::shared_ptr<skip_node> mNext[MAX_LEVEL];
 
+	// the number of level 0 links that mNext[level] skips over
+	size_t mSpan[MAX_LEVEL] = {};
+
 	Value mValue;
 	Key mKey;
 
@@ -23,32 +64,81 @@ public:
 		mHead = std::make_shared<skip_node<Key, Value>>(std::numeric_limits<Key>::min(), Value());
 		mTail = std::make_shared<skip_node<Key, Value>>(std::numeric_limits<Key>::max(), Value());
 
-		for (size_t index = 0; index < MAX_LEVEL; index++)
+		for (size_t index = 0; index < MAX_LEVEL; index++) {
 			mHead->mNext[index] = mTail;
+			mHead->mSpan[index] = 1;
+		}
 
 		mSize = 0;
 	}
 
-	void insert(const Key& key, const Value& value) {
+	// release the nodes one by one, the default destructor releases the chain of shared_ptr recursively
+	~skip_list() {
+		auto node = mHead;
+
+		while (node != nullptr) {
+			const auto next = node->mNext[0];
+
+			for (auto level = 0; level < MAX_LEVEL; level++) node->mNext[level].reset();
+
+			node = next;
+		}
+	}
+
+	skip_list(const skip_list&) = delete;
+
+	skip_list& operator=(const skip_list&) = delete;
+
+	// return false if the key is existed, the value will not be changed
+	auto insert(const Key& key, const Value& value) -> bool {
 		auto node = mHead;
-		auto layer = random_level();
 
 		std::shared_ptr<skip_node<Key, Value>> needUpdate[MAX_LEVEL];
 
+		// position of needUpdate[level] in level 0, the head is position 0
+		size_t position[MAX_LEVEL];
+
 		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
-			while (key > node->mNext[level]->mKey&& node->mNext[level] != mTail) node = node->mNext[level];
+			position[level] = level == MAX_LEVEL - 1 ? 0 : position[level + 1];
+
+			while (key > node->mNext[level]->mKey&& node->mNext[level] != mTail) {
+				position[level] = position[level] + node->mSpan[level];
+				node = node->mNext[level];
+			}
 
 			needUpdate[level] = node;
 		}
 
+		if (needUpdate[0]->mNext[0] != mTail && needUpdate[0]->mNext[0]->mKey == key) return false;
+
+		const auto layer = random_skip_level();
 		const auto newNode = std::make_shared<skip_node<Key, Value>>(key, value);
 
 		for (auto level = layer; level >= 0; level--) {
 			newNode->mNext[level] = needUpdate[level]->mNext[level];
 			needUpdate[level]->mNext[level] = newNode;
+
+			newNode->mSpan[level] = needUpdate[level]->mSpan[level] - (position[0] - position[level]);
+			needUpdate[level]->mSpan[level] = position[0] - position[level] + 1;
 		}
 
+		for (auto level = layer + 1; level < MAX_LEVEL; level++)
+			needUpdate[level]->mSpan[level]++;
+
 		mSize++;
+
+		return true;
+	}
+
+	// return true if the key is inserted, false if the value of existed key is assigned
+	auto insert_or_assign(const Key& key, const Value& value) -> bool {
+		const auto node = find_node(key);
+
+		if (node == nullptr) return insert(key, value);
+
+		node->mValue = value;
+
+		return false;
 	}
 
 	auto erase(const Key& key) -> bool {
@@ -62,31 +152,126 @@ public:
 			needUpdate[level] = node;
 		}
 
-		auto result = false;
+		// the node to remove is always the first node with the key in level 0
+		const auto target = needUpdate[0]->mNext[0];
 
-		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
-			if (needUpdate[level]->mNext[level]->mKey == key) {
-				result = true;
+		if (target == mTail || target->mKey != key) return false;
 
-				needUpdate[level]->mNext[level] = needUpdate[level]->mNext[level]->mNext[level];
+		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
+			if (needUpdate[level]->mNext[level] == target) {
+				needUpdate[level]->mSpan[level] = needUpdate[level]->mSpan[level] + target->mSpan[level];
+				needUpdate[level]->mNext[level] = target->mNext[level];
 			}
+
+			needUpdate[level]->mSpan[level]--;
 		}
 
 		mSize--;
 
-		return result;
+		return true;
+	}
+
+	// return nullptr if the key is not existed
+	auto find(const Key& key) -> Value* {
+		const auto node = find_node(key);
+
+		return node == nullptr ? nullptr : &node->mValue;
 	}
 
-	auto find(const Key& key) const -> Value {
+	auto find(const Key& key) const -> const Value* {
+		const auto node = find_node(key);
+
+		return node == nullptr ? nullptr : &node->mValue;
+	}
+
+	auto contains(const Key& key) const -> bool {
+		return find_node(key) != nullptr;
+	}
+
+	/*
+	 * build the list in one pass without search, the list should be empty
+	 * next(key, value, level) should output the keys in strictly ascending order(it is not checked), level < 0 means a random level
+	 */
+	template<typename Function>
+	void assign_sorted(size_t count, Function&& next) {
+		std::shared_ptr<skip_node<Key, Value>> last[MAX_LEVEL];
+		size_t position[MAX_LEVEL];
+
+		for (auto level = 0; level < MAX_LEVEL; level++) {
+			last[level] = mHead;
+			position[level] = 0;
+		}
+
+		for (size_t index = 1; index <= count; index++) {
+			auto key = Key();
+			auto value = Value();
+			auto layer = -1;
+
+			next(key, value, layer);
+
+			if (layer < 0 || layer >= MAX_LEVEL) layer = random_skip_level();
+
+			const auto newNode = std::make_shared<skip_node<Key, Value>>(key, value);
+
+			for (auto level = 0; level <= layer; level++) {
+				last[level]->mNext[level] = newNode;
+				last[level]->mSpan[level] = index - position[level];
+				last[level] = newNode;
+				position[level] = index;
+			}
+		}
+
+		for (auto level = 0; level < MAX_LEVEL; level++) {
+			last[level]->mNext[level] = mTail;
+			last[level]->mSpan[level] = count + 1 - position[level];
+		}
+
+		mSize = count;
+	}
+
+	// call function(key, value) for each key in [first, last] in ascending order
+	template<typename Function>
+	void for_each_range(const Key& first, const Key& last, Function&& function) const {
+		auto node = mHead.get();
+
+		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
+			while (first > node->mNext[level]->mKey&& node->mNext[level] != mTail) node = node->mNext[level].get();
+		}
+
+		for (node = node->mNext[0].get(); node != mTail.get() && !(last < node->mKey); node = node->mNext[0].get())
+			function(node->mKey, node->mValue);
+	}
+
+	// the key with index-th smallest(start with 0), index should be less than size()
+	auto select(size_t index) const -> Key {
 		auto node = mHead;
 
+		size_t position = 0;
+
 		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
-			while (key > node->mNext[level]->mKey&& node->mNext[level] != mTail) node = node->mNext[level];
+			while (position + node->mSpan[level] <= index + 1 && node->mNext[level] != mTail) {
+				position = position + node->mSpan[level];
+				node = node->mNext[level];
+			}
+		}
 
-			if (key == node->mNext[level]->mKey) return node->mNext[level]->mValue;
+		return node->mKey;
+	}
+
+	// the number of keys that less than key
+	auto rank(const Key& key) const -> size_t {
+		auto node = mHead;
+
+		size_t position = 0;
+
+		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
+			while (key > node->mNext[level]->mKey&& node->mNext[level] != mTail) {
+				position = position + node->mSpan[level];
+				node = node->mNext[level];
+			}
 		}
 
-		return "-1";
+		return position;
 	}
 
 	auto min() const -> Key {
@@ -109,15 +294,16 @@ public:
 
 	auto tail() const noexcept -> std::shared_ptr<skip_node<Key, Value>> { return mTail; }
 private:
-	static auto random_level() -> int {
-		static std::default_random_engine random;
-		static std::uniform_int_distribution<int> vRange(0, 10000);
+	auto find_node(const Key& key) const -> skip_node<Key, Value>* {
+		auto node = mHead.get();
 
-		int level = 0;
+		for (auto level = MAX_LEVEL - 1; level >= 0; level--) {
+			while (key > node->mNext[level]->mKey&& node->mNext[level] != mTail) node = node->mNext[level].get();
 
-		while (vRange(random) % 2 && level < MAX_LEVEL - 1) level++;
+			if (node->mNext[level] != mTail && key == node->mNext[level]->mKey) return node->mNext[level].get();
+		}
 
-		return level;
+		return nullptr;
 	}
 private:
 	std::shared_ptr<skip_node<Key, Value>> mHead;
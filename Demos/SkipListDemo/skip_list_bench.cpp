@@ -0,0 +1,595 @@
+#include "skip_list_snapshot.hpp"
+#include "fat_skip_list.hpp"
+#include "skip_list.hpp"
+#include "../bench_common.hpp"
+
+#include <shared_mutex>
+#include <mutex>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <new>
+#include <set>
+#include <map>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+/*
+ * headless benchmark of skip_list
+ * suite mode runs insert/find/erase/range/mixed workloads with uniform, sequential and zipf keys on 1..N threads,
+ * and reports ops/s, p50/p99 latency, memory per element and cache misses per operation(linux only).
+ * compare mode runs the comparisons with std::multiset, std::map and fat_skip_list(with the cache misses per operation).
+ * snapshot mode compares the snapshot loading with rebuilding the list by insert.
+ */
+
+// hardware cache miss counter of this process, it is invalid when perf_event_open is not available
+class cache_counter {
+public:
+	cache_counter() {
+#ifdef __linux__
+		perf_event_attr attribute;
+
+		std::memset(&attribute, 0, sizeof(attribute));
+
+		attribute.type = PERF_TYPE_HARDWARE;
+		attribute.size = sizeof(attribute);
+		attribute.config = PERF_COUNT_HW_CACHE_MISSES;
+		attribute.disabled = 1;
+		attribute.inherit = 1;
+		attribute.exclude_kernel = 1;
+		attribute.exclude_hv = 1;
+
+		mFile = static_cast<int>(syscall(__NR_perf_event_open, &attribute, 0, -1, -1, 0));
+#endif
+	}
+
+	~cache_counter() {
+#ifdef __linux__
+		if (mFile != -1) close(mFile);
+#endif
+	}
+
+	cache_counter(const cache_counter&) = delete;
+
+	cache_counter& operator=(const cache_counter&) = delete;
+
+	void start() {
+#ifdef __linux__
+		if (mFile == -1) return;
+
+		ioctl(mFile, PERF_EVENT_IOC_RESET, 0);
+		ioctl(mFile, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+
+	// the number of cache misses since start(), -1 if the counter is invalid
+	auto stop() -> long long {
+#ifdef __linux__
+		if (mFile == -1) return -1;
+
+		ioctl(mFile, PERF_EVENT_IOC_DISABLE, 0);
+
+		long long count = 0;
+
+		if (read(mFile, &count, sizeof(count)) != sizeof(count)) return -1;
+
+		return count;
+#else
+		return -1;
+#endif
+	}
+private:
+	int mFile = -1;
+};
+
+// report the time of function and the cache misses per operation, the misses are n/a if the counter is invalid
+template <typename Function>
+void report_misses(const std::string& name, size_t count, const Function& function) {
+	cache_counter counter;
+
+	counter.start();
+
+	const auto seconds = time_used(function);
+	const auto misses = counter.stop();
+
+	report(name, count, seconds);
+
+	std::cout << name << " cache misses : ";
+
+	if (misses < 0) std::cout << "n/a";
+	else std::cout << static_cast<double>(misses) / count << " per op";
+
+	std::cout << "." << std::endl;
+}
+
+// compare rank/select of skip_list with std::multiset + std::distance
+void bench_rank_select(size_t count, size_t queries) {
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<int> range(1, std::numeric_limits<int>::max() - 1);
+
+	std::vector<int> keys(count);
+	std::vector<int> query_keys(queries);
+	std::vector<size_t> query_index(queries);
+
+	// skip_list rejects the same key, so the keys are unique to keep the multiset the same as list
+	std::set<int> used;
+
+	for (auto& key : keys) {
+		do key = range(rng); while (!used.insert(key).second);
+	}
+
+	for (auto& key : query_keys) key = range(rng);
+	for (auto& index : query_index) index = rng() % count;
+
+	skip_list<int, int> list;
+	std::multiset<int> set;
+
+	report("skip_list insert", count, time_used([&]() { for (const auto& key : keys) list.insert(key, key); }));
+	report("multiset insert", count, time_used([&]() { for (const auto& key : keys) set.insert(key); }));
+
+	size_t checksum0 = 0;
+	size_t checksum1 = 0;
+
+	report("skip_list select", queries, time_used([&]() {
+		for (const auto& index : query_index) checksum0 = checksum0 + list.select(index);
+	}));
+
+	report("multiset select", queries, time_used([&]() {
+		for (const auto& index : query_index) checksum1 = checksum1 + *std::next(set.begin(), index);
+	}));
+
+	report("skip_list rank", queries, time_used([&]() {
+		for (const auto& key : query_keys) checksum0 = checksum0 + list.rank(key);
+	}));
+
+	report("multiset rank", queries, time_used([&]() {
+		for (const auto& key : query_keys) checksum1 = checksum1 + std::distance(set.begin(), set.lower_bound(key));
+	}));
+
+	if (checksum0 != checksum1) std::cout << "error : the results of skip_list and multiset are different." << std::endl;
+}
+
+// compare find of single key node layout with fat node layout
+void bench_find(size_t count, size_t queries) {
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<int> range(1, std::numeric_limits<int>::max() - 1);
+
+	std::vector<int> keys(count);
+	std::vector<int> query_keys(queries);
+
+	for (auto& key : keys) key = range(rng);
+	for (auto& key : query_keys) key = keys[rng() % count];
+
+	skip_list<int, int> list;
+	fat_skip_list<int, int> fat_list;
+
+	// the fat layout is meant to save cache misses, so they are counted with the time
+	report_misses("skip_list insert", count, [&]() { for (const auto& key : keys) list.insert(key, key); });
+	report_misses("fat_skip_list insert", count, [&]() { for (const auto& key : keys) fat_list.insert(key, key); });
+
+	size_t checksum0 = 0;
+	size_t checksum1 = 0;
+
+	report_misses("skip_list find", queries, [&]() {
+		for (const auto& key : query_keys) checksum0 = checksum0 + (list.find(key) != nullptr ? 0 : 1);
+	});
+
+	report_misses("fat_skip_list find", queries, [&]() {
+		for (const auto& key : query_keys) checksum1 = checksum1 + (fat_list.find(key) != nullptr ? 0 : 1);
+	});
+
+	if (checksum0 != checksum1) std::cout << "error : some keys are not found." << std::endl;
+}
+
+// compare the map interface of skip_list with std::map
+void bench_map(size_t count, size_t queries) {
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<int> range(1, std::numeric_limits<int>::max() - 1);
+
+	std::vector<int> keys(count);
+	std::vector<int> query_keys(queries);
+
+	for (auto& key : keys) key = range(rng);
+	for (auto& key : query_keys) key = rng() % 2 ? keys[rng() % count] : range(rng);
+
+	skip_list<int, int> list;
+	std::map<int, int> map;
+
+	report("skip_list insert", count, time_used([&]() { for (const auto& key : keys) list.insert(key, key); }));
+	report("map insert", count, time_used([&]() { for (const auto& key : keys) map.insert({ key, key }); }));
+
+	if (list.size() != map.size()) std::cout << "error : the sizes of skip_list and map are different." << std::endl;
+
+	size_t checksum0 = 0;
+	size_t checksum1 = 0;
+
+	report("skip_list find", queries, time_used([&]() {
+		for (const auto& key : query_keys) {
+			const auto value = list.find(key);
+
+			if (value != nullptr) checksum0 = checksum0 + *value;
+		}
+	}));
+
+	report("map find", queries, time_used([&]() {
+		for (const auto& key : query_keys) {
+			const auto it = map.find(key);
+
+			if (it != map.end()) checksum1 = checksum1 + it->second;
+		}
+	}));
+
+	report("skip_list insert_or_assign", queries, time_used([&]() {
+		for (const auto& key : query_keys) list.insert_or_assign(key, key + 1);
+	}));
+
+	report("map insert_or_assign", queries, time_used([&]() {
+		for (const auto& key : query_keys) map.insert_or_assign(key, key + 1);
+	}));
+
+	report("skip_list erase", queries, time_used([&]() {
+		for (const auto& key : query_keys) checksum0 = checksum0 + (list.erase(key) ? 1 : 0);
+	}));
+
+	report("map erase", queries, time_used([&]() {
+		for (const auto& key : query_keys) checksum1 = checksum1 + map.erase(key);
+	}));
+
+	if (checksum0 != checksum1 || list.size() != map.size())
+		std::cout << "error : the results of skip_list and map are different." << std::endl;
+}
+
+
+enum class distribution : unsigned {
+	uniform,
+	sequential,
+	zipf
+};
+
+enum class operation : unsigned {
+	insert,
+	find,
+	erase,
+	range
+};
+
+struct workload {
+	std::string name;
+
+	// the percent of each operation, the sum should be 100
+	int insert_percent = 0;
+	int find_percent = 0;
+	int erase_percent = 0;
+	int range_percent = 0;
+
+	// fill the list with the keys before the workload runs
+	bool prefill = true;
+};
+
+auto distribution_name(distribution type) -> std::string {
+	if (type == distribution::uniform) return "uniform";
+	if (type == distribution::sequential) return "sequential";
+
+	return "zipf";
+}
+
+// generate the keys of operations, the hot keys of zipf are the first keys in the key set
+class key_generator {
+public:
+	key_generator(distribution type, const std::vector<int>& keys, size_t seed) :
+		mType(type), mKeys(keys), mRandom(seed), mNext(0)
+	{
+		if (mType != distribution::zipf) return;
+
+		const auto exponent = 0.99;
+
+		mWeights = std::vector<double>(mKeys.size());
+
+		auto sum = 0.0;
+
+		for (size_t index = 0; index < mKeys.size(); index++) {
+			sum = sum + 1.0 / std::pow(static_cast<double>(index + 1), exponent);
+
+			mWeights[index] = sum;
+		}
+
+		for (auto& weight : mWeights) weight = weight / sum;
+	}
+
+	auto next() -> int {
+		if (mType == distribution::sequential) return mKeys[mNext++ % mKeys.size()];
+
+		if (mType == distribution::uniform) return mKeys[mRandom() % mKeys.size()];
+
+		const auto value = std::uniform_real_distribution<double>(0, 1)(mRandom);
+		const auto index = std::lower_bound(mWeights.begin(), mWeights.end(), value) - mWeights.begin();
+
+		return mKeys[std::min(static_cast<size_t>(index), mKeys.size() - 1)];
+	}
+private:
+	distribution mType;
+
+	const std::vector<int>& mKeys;
+	std::vector<double> mWeights;
+
+	std::mt19937_64 mRandom;
+
+	size_t mNext;
+};
+
+auto make_keys(distribution type, size_t count) -> std::vector<int> {
+	std::vector<int> keys(count);
+
+	if (type == distribution::sequential) {
+		for (size_t index = 0; index < count; index++) keys[index] = static_cast<int>(index + 1);
+
+		return keys;
+	}
+
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<int> range(1, std::numeric_limits<int>::max() - 1);
+	std::set<int> used;
+
+	for (auto& key : keys) {
+		do key = range(rng); while (!used.insert(key).second);
+	}
+
+	return keys;
+}
+
+auto percentile(const std::vector<long long>& sorted, double percent) -> long long {
+	if (sorted.empty()) return 0;
+
+	return sorted[std::min(sorted.size() - 1, static_cast<size_t>(sorted.size() * percent))];
+}
+
+// the skip_list is not thread-safe, so readers share a lock and writers hold it exclusively
+void run_workload(const workload& work, distribution type, const std::vector<int>& keys,
+	size_t operations, size_t threads)
+{
+	skip_list<int, int> list;
+	std::shared_mutex mutex;
+
+	if (work.prefill) for (const auto& key : keys) list.insert(key, key);
+
+	// the width of range is about 100 keys
+	const auto range_width = type == distribution::sequential ? 100ll :
+		100ll * (std::numeric_limits<int>::max() / static_cast<long long>(keys.size()));
+
+	// generate the operations before timing, so the random generator is not measured
+	std::vector<std::vector<std::pair<operation, int>>> tasks(threads);
+
+	for (size_t thread = 0; thread < threads; thread++) {
+		key_generator generator(type, keys, thread + 1);
+		std::mt19937 rng(static_cast<unsigned>(thread + 1));
+
+		const auto count = operations / threads + (thread < operations % threads ? 1 : 0);
+
+		for (size_t index = 0; index < count; index++) {
+			const auto percent = static_cast<int>(rng() % 100);
+
+			auto kind = operation::range;
+
+			if (percent < work.insert_percent) kind = operation::insert;
+			else if (percent < work.insert_percent + work.find_percent) kind = operation::find;
+			else if (percent < work.insert_percent + work.find_percent + work.erase_percent) kind = operation::erase;
+
+			tasks[thread].push_back({ kind, generator.next() });
+		}
+	}
+
+	std::vector<std::vector<long long>> latencies(threads);
+	std::vector<std::thread> workers;
+	std::atomic<size_t> checksum(0);
+
+	cache_counter counter;
+
+	counter.start();
+
+	const auto seconds = time_used([&]() {
+		for (size_t thread = 0; thread < threads; thread++) {
+			workers.push_back(std::thread([&, thread]() {
+				auto& latency = latencies[thread];
+
+				size_t sum = 0;
+
+				latency.reserve(tasks[thread].size());
+
+				for (const auto& task : tasks[thread]) {
+					const auto start = time_clock::now();
+
+					if (task.first == operation::insert) {
+						std::unique_lock<std::shared_mutex> lock(mutex);
+
+						list.insert(task.second, task.second);
+					}
+
+					if (task.first == operation::erase) {
+						std::unique_lock<std::shared_mutex> lock(mutex);
+
+						list.erase(task.second);
+					}
+
+					if (task.first == operation::find) {
+						std::shared_lock<std::shared_mutex> lock(mutex);
+
+						sum = sum + (list.contains(task.second) ? 1 : 0);
+					}
+
+					if (task.first == operation::range) {
+						std::shared_lock<std::shared_mutex> lock(mutex);
+
+						const auto last = std::min(static_cast<long long>(std::numeric_limits<int>::max() - 1), task.second + range_width);
+
+						list.for_each_range(task.second, static_cast<int>(last), [&](const int&, const int&) { sum = sum + 1; });
+					}
+
+					const auto end = time_clock::now();
+
+					latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+				}
+
+				checksum.fetch_add(sum);
+			}));
+		}
+
+		for (auto& worker : workers) worker.join();
+	});
+
+	const auto misses = counter.stop();
+
+	std::vector<long long> merged;
+
+	for (const auto& latency : latencies) merged.insert(merged.end(), latency.begin(), latency.end());
+
+	std::sort(merged.begin(), merged.end());
+
+	std::cout << std::left
+		<< std::setw(12) << work.name
+		<< std::setw(12) << distribution_name(type)
+		<< std::setw(9) << threads
+		<< std::setw(14) << static_cast<long long>(operations / seconds)
+		<< std::setw(10) << percentile(merged, 0.50)
+		<< std::setw(10) << percentile(merged, 0.99);
+
+	if (misses < 0) std::cout << "n/a";
+	else std::cout << static_cast<double>(misses) / operations;
+
+	std::cout << std::endl;
+}
+
+void bench_suite(size_t count, size_t operations, size_t max_threads) {
+	const std::vector<workload> workloads = {
+		{ "insert", 100, 0, 0, 0, false },
+		{ "find", 0, 100, 0, 0, true },
+		{ "erase", 0, 0, 100, 0, true },
+		{ "range", 0, 0, 0, 100, true },
+		{ "read-90", 5, 90, 5, 0, true },
+		{ "read-50", 25, 50, 25, 0, true }
+	};
+
+	const std::vector<distribution> distributions = {
+		distribution::uniform,
+		distribution::sequential,
+		distribution::zipf
+	};
+
+	for (const auto& type : distributions) {
+		const auto keys = make_keys(type, count);
+
+		skip_list<int, int> list;
+
+		const auto before = allocated_bytes.load();
+
+		for (const auto& key : keys) list.insert(key, key);
+
+		const auto bytes = allocated_bytes.load() - before;
+
+		std::cout << distribution_name(type) << " : " << count << " elements, "
+			<< static_cast<double>(bytes) / count << " bytes per element." << std::endl;
+	}
+
+	std::cout << std::left
+		<< std::setw(12) << "workload"
+		<< std::setw(12) << "keys"
+		<< std::setw(9) << "threads"
+		<< std::setw(14) << "ops/s"
+		<< std::setw(10) << "p50(ns)"
+		<< std::setw(10) << "p99(ns)"
+		<< "misses/op" << std::endl;
+
+	for (const auto& type : distributions) {
+		const auto keys = make_keys(type, count);
+
+		for (const auto& work : workloads) {
+			// the threads are doubled, and the last step is clamped to max_threads so it always runs
+			for (size_t threads = 1; threads <= max_threads; threads = threads == max_threads ? threads + 1 : std::min(threads * 2, max_threads))
+				run_workload(work, type, keys, operations, threads);
+		}
+	}
+}
+
+// compare loading a snapshot with inserting the keys one by one
+void bench_snapshot(size_t count, const std::string& file_name) {
+	const auto keys = make_keys(distribution::uniform, count);
+
+	skip_list<int, int> list;
+
+	for (const auto& key : keys) list.insert(key, key);
+
+	for (const auto store_levels : { true, false }) {
+		const auto name = std::string(store_levels ? "with levels" : "without levels");
+
+		report("save snapshot " + name, count, time_used([&]() { save_snapshot(list, file_name, store_levels); }));
+
+		std::shared_ptr<skip_list<int, int>> loaded;
+
+		report("load snapshot " + name, count, time_used([&]() { loaded = load_snapshot<int, int>(file_name); }));
+
+		if (loaded == nullptr || loaded->size() != list.size() || loaded->select(count / 2) != list.select(count / 2))
+			std::cout << "error : the snapshot is different from the list." << std::endl;
+	}
+
+	skip_list<int, int> rebuilt;
+
+	report("rebuild by insert", count, time_used([&]() {
+		list.for_each_range(list.min(), list.max(), [&](const int& key, const int& value) { rebuilt.insert(key, value); });
+	}));
+
+	std::remove(file_name.c_str());
+}
+
+// skip_list_bench [suite count operations threads] | [compare count queries] | [snapshot count file]
+int main(int argc, char** argv) {
+	const std::string mode = argc >= 2 ? argv[1] : "suite";
+
+	size_t count = 100000;
+	size_t operations = 100000;
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+	if (argc >= 3) count = std::stoul(argv[2]);
+
+	if (mode == "snapshot") {
+		bench_snapshot(count, argc >= 4 ? argv[3] : "skip_list.snapshot");
+
+		return 0;
+	}
+
+	if (argc >= 4) operations = std::stoul(argv[3]);
+	if (argc >= 5) threads = std::stoul(argv[4]);
+
+	if (mode == "compare") {
+		if (argc < 4) operations = 1000;
+
+		bench_rank_select(count, operations);
+		bench_find(count, operations);
+		bench_map(count, operations);
+
+		return 0;
+	}
+
+	if (mode != "suite") {
+		std::cout << "usage : skip_list_bench [suite count operations threads] | [compare count queries] | [snapshot count file]" << std::endl;
+
+		return 1;
+	}
+
+	bench_suite(count, operations, threads);
+
+	return 0;
+}
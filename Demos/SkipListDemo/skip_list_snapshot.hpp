@@ -0,0 +1,131 @@
+#pragma once
+
+#include "skip_list.hpp"
+#include "../file_mapping.hpp"
+
+#include <type_traits>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * snapshot of skip list is a binary file of the level 0 in ascending order
+ * header : skip_list_snapshot_header
+ * record : key, value and the level of node(1 byte, only if the levels are stored)
+ * the loader maps the file to memory and appends the records to the list in one pass, so no search is needed.
+ */
+
+struct skip_list_snapshot_header {
+	char magic[8] = { 'S', 'K', 'I', 'P', 'L', 'I', 'S', 'T' };
+
+	std::uint32_t version = 1;
+	std::uint32_t has_levels = 0;
+	std::uint32_t key_size = 0;
+	std::uint32_t value_size = 0;
+
+	std::uint64_t count = 0;
+};
+
+template<typename Key, typename Value>
+auto save_snapshot(const skip_list<Key, Value>& list, const std::string& file_name, bool store_levels = true) -> bool
+{
+	static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+		"the key and value of snapshot should be trivially copyable.");
+
+	std::ofstream stream(file_name, std::ios::binary);
+
+	if (!stream.is_open()) return false;
+
+	skip_list_snapshot_header header;
+
+	header.has_levels = store_levels ? 1 : 0;
+	header.key_size = sizeof(Key);
+	header.value_size = sizeof(Value);
+	header.count = list.size();
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	const auto record_size = sizeof(Key) + sizeof(Value) + (store_levels ? 1 : 0);
+
+	// write the records by chunks to avoid a write call per record
+	std::vector<char> buffer;
+
+	buffer.reserve(record_size * 4096);
+
+	for (auto node = list.head()->mNext[0]; node != list.tail(); node = node->mNext[0]) {
+		const auto offset = buffer.size();
+
+		buffer.resize(offset + record_size);
+
+		std::memcpy(buffer.data() + offset, &node->mKey, sizeof(Key));
+		std::memcpy(buffer.data() + offset + sizeof(Key), &node->mValue, sizeof(Value));
+
+		if (store_levels) {
+			std::uint8_t level = 0;
+
+			while (level + 1 < MAX_LEVEL && node->mNext[level + 1] != nullptr) level++;
+
+			buffer[offset + sizeof(Key) + sizeof(Value)] = static_cast<char>(level);
+		}
+
+		if (buffer.size() + record_size > buffer.capacity()) {
+			stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			buffer.clear();
+		}
+	}
+
+	stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+	return stream.good();
+}
+
+// return nullptr if the file is not a valid snapshot of skip_list<Key, Value> or its keys are not strictly ascending
+template<typename Key, typename Value>
+auto load_snapshot(const std::string& file_name) -> std::shared_ptr<skip_list<Key, Value>>
+{
+	static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+		"the key and value of snapshot should be trivially copyable.");
+
+	const file_mapping mapping(file_name, mapping_mode::sequential);
+
+	if (mapping.data() == nullptr || mapping.size() < sizeof(skip_list_snapshot_header)) return nullptr;
+
+	skip_list_snapshot_header header;
+	skip_list_snapshot_header expected;
+
+	std::memcpy(&header, mapping.data(), sizeof(header));
+
+	if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) return nullptr;
+
+	if (header.version != expected.version || header.key_size != sizeof(Key) || header.value_size != sizeof(Value))
+		return nullptr;
+
+	const auto record_size = sizeof(Key) + sizeof(Value) + (header.has_levels != 0 ? 1 : 0);
+
+	if ((mapping.size() - sizeof(header)) / record_size < header.count) return nullptr;
+
+	auto list = std::make_shared<skip_list<Key, Value>>();
+	auto record = mapping.data() + sizeof(header);
+
+	// assign_sorted trusts the order of keys, so the keys are checked while they are read
+	// they should be strictly ascending and between the keys of head and tail
+	auto previous = std::numeric_limits<Key>::min();
+	auto sorted = true;
+
+	list->assign_sorted(static_cast<size_t>(header.count), [&](Key& key, Value& value, int& level) {
+		std::memcpy(&key, record, sizeof(Key));
+		std::memcpy(&value, record + sizeof(Key), sizeof(Value));
+
+		level = header.has_levels != 0 ? static_cast<std::uint8_t>(record[sizeof(Key) + sizeof(Value)]) : -1;
+
+		record = record + record_size;
+
+		if (!(previous < key) || !(key < std::numeric_limits<Key>::max())) sorted = false;
+
+		previous = key;
+	});
+
+	return sorted ? list : nullptr;
+}
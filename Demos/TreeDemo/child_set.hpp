@@ -0,0 +1,432 @@
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/*
+ * child set is a sorted set of ints for the children of tree node
+ * small : at most SmallCapacity children are kept in node without allocation
+ * large : the children are kept in sorted chunks(at most ChunkCapacity children per chunk), the counts of chunks
+ * are in a fenwick tree, so rank/select are O(log d) and inserting or erasing moves at most one chunk.
+ * the iterators are invalidated by any insert or erase, like std::vector.
+ */
+
+class child_set {
+public:
+	static constexpr size_t SmallCapacity = 4;
+	static constexpr size_t ChunkCapacity = 128;
+
+	class const_iterator {
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = int;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const int*;
+		using reference = const int&;
+	public:
+		const_iterator() = default;
+
+		const_iterator(const child_set* set, size_t chunk, size_t position) :
+			mSet(set), mChunk(chunk), mPosition(position) {}
+
+		auto operator*() const -> reference { return mSet->chunk_data(mChunk)[mPosition]; }
+
+		auto operator->() const -> pointer { return &mSet->chunk_data(mChunk)[mPosition]; }
+
+		auto operator++() -> const_iterator& {
+			if (++mPosition == mSet->chunk_size(mChunk)) mChunk++, mPosition = 0;
+
+			return *this;
+		}
+
+		auto operator++(int) -> const_iterator { auto result = *this; ++*this; return result; }
+
+		auto operator--() -> const_iterator& {
+			if (mPosition == 0) mChunk--, mPosition = mSet->chunk_size(mChunk);
+
+			mPosition--;
+
+			return *this;
+		}
+
+		auto operator--(int) -> const_iterator { auto result = *this; --*this; return result; }
+
+		bool operator==(const const_iterator& other) const { return mChunk == other.mChunk && mPosition == other.mPosition; }
+
+		bool operator!=(const const_iterator& other) const { return !(*this == other); }
+	private:
+		friend class child_set;
+
+		const child_set* mSet = nullptr;
+
+		size_t mChunk = 0;
+		size_t mPosition = 0;
+	};
+
+	using iterator = const_iterator;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+	using reverse_iterator = const_reverse_iterator;
+	using value_type = int;
+	using size_type = size_t;
+public:
+	child_set() = default;
+
+	template<typename Iterator>
+	child_set(Iterator first, Iterator last) { for (; first != last; ++first) insert(end(), *first); }
+
+	child_set(std::initializer_list<int> values) : child_set(values.begin(), values.end()) {}
+
+	child_set(const child_set&) = default;
+
+	// the moved set is empty, the nodes of tree are moved when the vector of nodes grows
+	child_set(child_set&& other) noexcept;
+
+	child_set& operator=(const child_set&) = default;
+
+	child_set& operator=(child_set&& other) noexcept;
+
+	auto insert(int value) -> std::pair<iterator, bool>;
+
+	// the hint is used when it is end() and value is greater than all children, it is O(1) in that case
+	auto insert(const_iterator hint, int value) -> iterator;
+
+	auto erase(int value) -> size_t;
+
+	auto find(int value) const -> const_iterator;
+
+	auto count(int value) const -> size_t { return find(value) != end() ? 1 : 0; }
+
+	// the number of children less than value
+	auto rank(int value) const -> size_t;
+
+	// the index-th child in ascending order, index should be less than size()
+	auto select(size_t index) const -> int;
+
+	void clear();
+
+	auto begin() const -> const_iterator { return const_iterator(this, 0, 0); }
+
+	auto end() const -> const_iterator { return const_iterator(this, chunk_count(), 0); }
+
+	auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator(end()); }
+
+	auto rend() const -> const_reverse_iterator { return const_reverse_iterator(begin()); }
+
+	bool empty() const noexcept { return mSize == 0; }
+
+	auto size() const noexcept -> size_t { return mSize; }
+
+	bool operator==(const child_set& other) const { return mSize == other.mSize && std::equal(begin(), end(), other.begin()); }
+
+	bool operator!=(const child_set& other) const { return !(*this == other); }
+private:
+	bool large() const noexcept { return !mChunks.empty(); }
+
+	auto chunk_count() const noexcept -> size_t { return large() ? mChunks.size() : (mSize == 0 ? 0 : 1); }
+
+	auto chunk_data(size_t chunk) const -> const int* { return large() ? mChunks[chunk].data() : mSmall; }
+
+	auto chunk_size(size_t chunk) const -> size_t { return large() ? mChunks[chunk].size() : mSize; }
+
+	// the first chunk whose last child is not less than value, the last chunk if there is no such chunk
+	auto lower_chunk(int value) const -> size_t;
+
+	void to_large();
+
+	void to_small();
+
+	// recompute the fenwick tree after the chunks are inserted or erased
+	void rebuild_counts();
+
+	void add_count(size_t chunk, int delta);
+
+	auto prefix_count(size_t chunk) const -> size_t;
+private:
+	int mSmall[SmallCapacity] = {};
+
+	size_t mSize = 0;
+
+	std::vector<std::vector<int>> mChunks;
+
+	// fenwick tree of the sizes of chunks, 1-indexed
+	std::vector<int> mCounts;
+};
+
+inline child_set::child_set(child_set&& other) noexcept :
+	mSize(other.mSize), mChunks(std::move(other.mChunks)), mCounts(std::move(other.mCounts))
+{
+	std::copy(other.mSmall, other.mSmall + SmallCapacity, mSmall);
+
+	other.clear();
+}
+
+inline child_set& child_set::operator=(child_set&& other) noexcept
+{
+	if (this == &other) return *this;
+
+	std::copy(other.mSmall, other.mSmall + SmallCapacity, mSmall);
+
+	mSize = other.mSize;
+	mChunks = std::move(other.mChunks);
+	mCounts = std::move(other.mCounts);
+
+	other.clear();
+
+	return *this;
+}
+
+inline auto child_set::insert(int value) -> std::pair<iterator, bool>
+{
+	if (!large()) {
+		const auto position = static_cast<size_t>(std::lower_bound(mSmall, mSmall + mSize, value) - mSmall);
+
+		if (position < mSize && mSmall[position] == value) return { iterator(this, 0, position), false };
+
+		if (mSize < SmallCapacity) {
+			std::copy_backward(mSmall + position, mSmall + mSize, mSmall + mSize + 1);
+
+			mSmall[position] = value;
+			mSize++;
+
+			return { iterator(this, 0, position), true };
+		}
+
+		to_large();
+	}
+
+	auto chunk = lower_chunk(value);
+	auto position = static_cast<size_t>(std::lower_bound(mChunks[chunk].begin(), mChunks[chunk].end(), value) - mChunks[chunk].begin());
+
+	if (position < mChunks[chunk].size() && mChunks[chunk][position] == value) return { iterator(this, chunk, position), false };
+
+	if (mChunks[chunk].size() == ChunkCapacity) {
+		// appending to the last chunk starts a new chunk, so the chunks are full when the children are sorted
+		if (chunk + 1 == mChunks.size() && position == ChunkCapacity) {
+			mChunks.emplace_back();
+			mChunks.back().reserve(ChunkCapacity);
+
+			chunk++;
+			position = 0;
+		}
+		else {
+			std::vector<int> upper;
+
+			upper.reserve(ChunkCapacity);
+			upper.assign(mChunks[chunk].begin() + ChunkCapacity / 2, mChunks[chunk].end());
+
+			mChunks[chunk].resize(ChunkCapacity / 2);
+			mChunks.insert(mChunks.begin() + chunk + 1, std::move(upper));
+
+			if (position > ChunkCapacity / 2) {
+				chunk++;
+				position = position - ChunkCapacity / 2;
+			}
+		}
+
+		mChunks[chunk].insert(mChunks[chunk].begin() + position, value);
+		mSize++;
+
+		rebuild_counts();
+
+		return { iterator(this, chunk, position), true };
+	}
+
+	mChunks[chunk].insert(mChunks[chunk].begin() + position, value);
+	mSize++;
+
+	add_count(chunk, 1);
+
+	return { iterator(this, chunk, position), true };
+}
+
+inline auto child_set::insert(const_iterator hint, int value) -> iterator
+{
+	// append to the last chunk without searching
+	if (hint == end() && large() && mChunks.back().size() < ChunkCapacity && mChunks.back().back() < value) {
+		mChunks.back().push_back(value);
+		mSize++;
+
+		add_count(mChunks.size() - 1, 1);
+
+		return iterator(this, mChunks.size() - 1, mChunks.back().size() - 1);
+	}
+
+	return insert(value).first;
+}
+
+inline auto child_set::erase(int value) -> size_t
+{
+	if (!large()) {
+		const auto position = static_cast<size_t>(std::lower_bound(mSmall, mSmall + mSize, value) - mSmall);
+
+		if (position == mSize || mSmall[position] != value) return 0;
+
+		std::copy(mSmall + position + 1, mSmall + mSize, mSmall + position);
+
+		mSize--;
+
+		return 1;
+	}
+
+	const auto chunk = lower_chunk(value);
+	const auto it = std::lower_bound(mChunks[chunk].begin(), mChunks[chunk].end(), value);
+
+	if (it == mChunks[chunk].end() || *it != value) return 0;
+
+	mChunks[chunk].erase(it);
+	mSize--;
+
+	if (mSize <= SmallCapacity / 2) {
+		to_small();
+
+		return 1;
+	}
+
+	// the iterators assume that no chunk is empty
+	if (mChunks[chunk].empty()) {
+		mChunks.erase(mChunks.begin() + chunk);
+
+		rebuild_counts();
+
+		return 1;
+	}
+
+	// merge the chunk with its next(or last) chunk when both of them are small, so the chunks are at least a quarter full
+	const auto first = chunk + 1 < mChunks.size() ? chunk : chunk - 1;
+	const auto second = first + 1;
+
+	if (mChunks.size() == 1 || mChunks[first].size() + mChunks[second].size() > ChunkCapacity / 2) {
+		add_count(chunk, -1);
+
+		return 1;
+	}
+
+	mChunks[first].insert(mChunks[first].end(), mChunks[second].begin(), mChunks[second].end());
+	mChunks.erase(mChunks.begin() + second);
+
+	rebuild_counts();
+
+	return 1;
+}
+
+inline auto child_set::find(int value) const -> const_iterator
+{
+	if (!large()) {
+		const auto position = static_cast<size_t>(std::lower_bound(mSmall, mSmall + mSize, value) - mSmall);
+
+		return position < mSize && mSmall[position] == value ? const_iterator(this, 0, position) : end();
+	}
+
+	const auto chunk = lower_chunk(value);
+	const auto it = std::lower_bound(mChunks[chunk].begin(), mChunks[chunk].end(), value);
+
+	if (it == mChunks[chunk].end() || *it != value) return end();
+
+	return const_iterator(this, chunk, static_cast<size_t>(it - mChunks[chunk].begin()));
+}
+
+inline auto child_set::rank(int value) const -> size_t
+{
+	if (!large()) return static_cast<size_t>(std::lower_bound(mSmall, mSmall + mSize, value) - mSmall);
+
+	const auto chunk = lower_chunk(value);
+
+	return prefix_count(chunk) +
+		static_cast<size_t>(std::lower_bound(mChunks[chunk].begin(), mChunks[chunk].end(), value) - mChunks[chunk].begin());
+}
+
+inline auto child_set::select(size_t index) const -> int
+{
+	if (!large()) return mSmall[index];
+
+	// walk down the fenwick tree to the chunk that holds the index-th child
+	size_t chunk = 0;
+	size_t step = 1;
+
+	while (step * 2 < mCounts.size()) step = step * 2;
+
+	for (; step != 0; step = step / 2) {
+		if (chunk + step < mCounts.size() && static_cast<size_t>(mCounts[chunk + step]) <= index) {
+			chunk = chunk + step;
+			index = index - mCounts[chunk];
+		}
+	}
+
+	return mChunks[chunk][index];
+}
+
+inline void child_set::clear()
+{
+	mChunks.clear();
+	mCounts.clear();
+
+	mSize = 0;
+}
+
+inline auto child_set::lower_chunk(int value) const -> size_t
+{
+	size_t left = 0;
+	size_t right = mChunks.size() - 1;
+
+	while (left < right) {
+		const auto middle = (left + right) / 2;
+
+		if (mChunks[middle].back() < value) left = middle + 1;
+		else right = middle;
+	}
+
+	return left;
+}
+
+inline void child_set::to_large()
+{
+	mChunks.emplace_back();
+	mChunks.back().reserve(ChunkCapacity);
+	mChunks.back().assign(mSmall, mSmall + mSize);
+
+	rebuild_counts();
+}
+
+inline void child_set::to_small()
+{
+	size_t size = 0;
+
+	for (const auto& chunk : mChunks) {
+		for (const auto& value : chunk) mSmall[size++] = value;
+	}
+
+	mChunks.clear();
+	mCounts.clear();
+}
+
+inline void child_set::rebuild_counts()
+{
+	mCounts.assign(mChunks.size() + 1, 0);
+
+	for (size_t index = 1; index < mCounts.size(); index++) {
+		mCounts[index] += static_cast<int>(mChunks[index - 1].size());
+
+		const auto parent = index + (index & (~index + 1));
+
+		if (parent < mCounts.size()) mCounts[parent] += mCounts[index];
+	}
+}
+
+inline void child_set::add_count(size_t chunk, int delta)
+{
+	for (auto index = chunk + 1; index < mCounts.size(); index += index & (~index + 1))
+		mCounts[index] += delta;
+}
+
+inline auto child_set::prefix_count(size_t chunk) const -> size_t
+{
+	size_t result = 0;
+
+	for (auto index = chunk; index > 0; index -= index & (~index + 1))
+		result = result + static_cast<size_t>(mCounts[index]);
+
+	return result;
+}
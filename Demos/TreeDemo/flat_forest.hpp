@@ -0,0 +1,310 @@
+#pragma once
+
+#include "tree.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+/*
+ * flat forest is a compact form of tree, every node costs four ints
+ * fathers : the father of node, 0 is the virtual root and -1 means the node is not in any tree
+ * offsets/children : the children of node are children[offsets[node], offsets[node + 1]) in ascending order(CSR)
+ * the traversal reads one contiguous array instead of the inline and chunked storage of child_set.
+ * the bulk constructors build the arrays by a counting sort of the nodes on their fathers.
+ */
+
+class flat_forest {
+public:
+	flat_forest() = default;
+
+	explicit flat_forest(const tree& tree);
+
+	// fathers[node] is the father of node, 0 for roots and -1 for the nodes not in any tree, fathers[0] is ignored
+	// the key of every node is its index, the nodes not in any tree keep their keys so they can be linked later
+	// an empty fathers builds a forest with only the virtual root
+	// threads = 0 means all hardware threads, small forests are built on the calling thread
+	// throw std::invalid_argument if a father is not -1 or a node in [0, fathers.size())
+	explicit flat_forest(const std::vector<int>& fathers, size_t threads = 0);
+
+	// the edges are (father, child) in any order, the nodes without father are not in any tree
+	// throw std::invalid_argument if a node is out of [0, size] or a child has more than one edge
+	flat_forest(size_t size, const std::vector<std::pair<int, int>>& edges, size_t threads = 0);
+
+	// rebuild the arrays from tree, the buffers are reused
+	void assign(const tree& tree);
+
+	void print() const;
+
+	bool in(int node) const;
+
+	auto to_tree() const->std::shared_ptr<tree>;
+
+	auto to_binary_tree() const->std::shared_ptr<binary_tree>;
+
+	// the buffers of output are reused
+	void to_tree(tree& output) const;
+
+	void to_binary_tree(binary_tree& output) const;
+
+	auto children_begin(int node) const -> const int*;
+
+	auto children_end(int node) const -> const int*;
+
+	auto size() const noexcept -> size_t;
+public:
+	// 0 indicate the virtual root
+	std::vector<int> fathers;
+	std::vector<int> keys;
+	std::vector<int> offsets;
+	std::vector<int> children;
+private:
+	// split [begin, end) into blocks and run function(block_begin, block_end) on the threads
+	template<typename Function>
+	static void parallel_for(size_t begin, size_t end, size_t threads, const Function& function);
+};
+
+template<typename Function>
+void flat_forest::parallel_for(size_t begin, size_t end, size_t threads, const Function& function)
+{
+	const auto block = (end - begin + threads - 1) / threads;
+
+	std::vector<std::thread> workers;
+
+	for (auto block_begin = begin; block_begin < end; block_begin += block) {
+		const auto block_end = std::min(block_begin + block, end);
+
+		workers.push_back(std::thread([=, &function]() { function(block_begin, block_end); }));
+	}
+
+	for (auto& worker : workers) worker.join();
+}
+
+inline flat_forest::flat_forest(const tree& tree)
+{
+	assign(tree);
+}
+
+inline flat_forest::flat_forest(const std::vector<int>& fathers, size_t threads)
+{
+	const auto count = std::max<size_t>(fathers.size(), 1);
+
+	// the fathers are used as the indices of offsets, so they are checked before any array is written
+	for (size_t index = 1; index < fathers.size(); index++) {
+		if (fathers[index] < -1 || fathers[index] >= static_cast<int>(count))
+			throw std::invalid_argument("the father of node " + std::to_string(index) + " is out of range.");
+	}
+
+	if (threads == 0) threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	if (count < (1 << 16)) threads = 1;
+
+	this->fathers = fathers;
+	this->fathers.resize(count);
+	this->fathers[0] = -1;
+
+	keys.resize(count);
+	offsets.assign(count + 1, 0);
+	children.resize(count);
+
+	if (threads == 1) {
+		for (size_t index = 1; index < count; index++) {
+			keys[index] = static_cast<int>(index);
+
+			if (fathers[index] != -1) offsets[fathers[index] + 1]++;
+		}
+
+		for (size_t index = 0; index < count; index++) offsets[index + 1] += offsets[index];
+
+		// the nodes are scattered in ascending order, so the children are sorted
+		std::vector<int> positions(offsets.begin(), offsets.end() - 1);
+
+		for (size_t index = 1; index < count; index++) {
+			if (fathers[index] != -1) children[positions[fathers[index]]++] = static_cast<int>(index);
+		}
+	}
+	else {
+		std::vector<std::atomic<int>> positions(count);
+
+		parallel_for(1, count, threads, [&](size_t begin, size_t end) {
+			for (auto index = begin; index < end; index++) {
+				keys[index] = static_cast<int>(index);
+
+				if (fathers[index] != -1) positions[fathers[index]].fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+
+		for (size_t index = 0; index < count; index++) {
+			offsets[index + 1] = offsets[index] + positions[index].load(std::memory_order_relaxed);
+
+			positions[index].store(offsets[index], std::memory_order_relaxed);
+		}
+
+		parallel_for(1, count, threads, [&](size_t begin, size_t end) {
+			for (auto index = begin; index < end; index++) {
+				if (fathers[index] != -1)
+					children[positions[fathers[index]].fetch_add(1, std::memory_order_relaxed)] = static_cast<int>(index);
+			}
+		});
+
+		// the threads scatter the children in any order, so sort the children of every node
+		parallel_for(0, count, threads, [&](size_t begin, size_t end) {
+			for (auto index = begin; index < end; index++)
+				std::sort(children.begin() + offsets[index], children.begin() + offsets[index + 1]);
+		});
+	}
+
+	children.resize(offsets[count]);
+}
+
+inline flat_forest::flat_forest(size_t size, const std::vector<std::pair<int, int>>& edges, size_t threads) :
+	flat_forest([&]() {
+		std::vector<int> fathers(size + 1, -1);
+
+		for (const auto& edge : edges) {
+			if (edge.first < 0 || edge.first > static_cast<int>(size) || edge.second <= 0 || edge.second > static_cast<int>(size))
+				throw std::invalid_argument("the edge (" + std::to_string(edge.first) + ", " + std::to_string(edge.second) + ") is out of range.");
+
+			if (fathers[edge.second] != -1)
+				throw std::invalid_argument("the node " + std::to_string(edge.second) + " has more than one father.");
+
+			fathers[edge.second] = edge.first;
+		}
+
+		return fathers;
+	}(), threads)
+{
+}
+
+inline void flat_forest::assign(const tree& tree)
+{
+	const auto count = tree.nodes.size();
+
+	fathers.assign(count, -1);
+	keys.resize(count);
+	offsets.resize(count + 1);
+
+	offsets[0] = 0;
+
+	for (size_t index = 0; index < count; index++) {
+		keys[index] = tree.nodes[index].key;
+		offsets[index + 1] = offsets[index] + static_cast<int>(tree.nodes[index].children.size());
+	}
+
+	children.resize(offsets[count]);
+
+	for (size_t index = 0; index < count; index++) {
+		auto position = offsets[index];
+
+		for (const auto& child : tree.nodes[index].children) {
+			children[position++] = child;
+			fathers[child] = static_cast<int>(index);
+		}
+	}
+}
+
+inline void flat_forest::print() const
+{
+	std::vector<int> stack;
+
+	for (auto root = children_begin(0); root != children_end(0); ++root) {
+		int output = 0;
+
+		stack.push_back(*root);
+
+		while (!stack.empty()) {
+			const auto node = stack.back();
+
+			stack.pop_back();
+
+			output = output ^ keys[node];
+
+			stack.insert(stack.end(), children_begin(node), children_end(node));
+		}
+
+		std::cout << output << " ";
+	}
+
+	std::cout << std::endl;
+}
+
+inline bool flat_forest::in(int node) const
+{
+	while (node > 0) node = fathers[node];
+
+	return node == 0;
+}
+
+inline auto flat_forest::to_tree() const -> std::shared_ptr<tree>
+{
+	auto tree = std::make_shared<::tree>(0, std::vector<int>());
+
+	to_tree(*tree);
+
+	return tree;
+}
+
+inline auto flat_forest::to_binary_tree() const -> std::shared_ptr<binary_tree>
+{
+	auto tree = std::make_shared<binary_tree>(0, 0);
+
+	to_binary_tree(*tree);
+
+	return tree;
+}
+
+inline void flat_forest::to_tree(tree& output) const
+{
+	output.nodes.resize(keys.size());
+
+	for (size_t index = 0; index < keys.size(); index++) {
+		auto& node = output.nodes[index];
+
+		node.key = keys[index];
+		node.children.clear();
+
+		// the children are sorted, so hint the end of set to insert in O(1)
+		for (auto child = children_begin(static_cast<int>(index)); child != children_end(static_cast<int>(index)); ++child)
+			node.children.insert(node.children.end(), *child);
+	}
+
+	output.rebuild();
+}
+
+inline void flat_forest::to_binary_tree(binary_tree& output) const
+{
+	output.nodes.resize(keys.size());
+	output.root = offsets[1] != offsets[0] ? children[offsets[0]] : 0;
+
+	for (size_t index = 0; index < keys.size(); index++) {
+		const auto begin = children_begin(static_cast<int>(index));
+		const auto end = children_end(static_cast<int>(index));
+
+		output.nodes[index].key = keys[index];
+		output.nodes[index].child = begin == end ? 0 : *begin;
+
+		// the brother of a child is set by its father, a node without father has no brother
+		if (fathers[index] == -1) output.nodes[index].brother = 0;
+
+		for (auto child = begin; child != end; ++child)
+			output.nodes[*child].brother = child + 1 != end ? *(child + 1) : 0;
+	}
+
+	output.rebuild();
+}
+
+inline auto flat_forest::children_begin(int node) const -> const int*
+{
+	return children.data() + offsets[node];
+}
+
+inline auto flat_forest::children_end(int node) const -> const int*
+{
+	return children.data() + offsets[node + 1];
+}
+
+inline auto flat_forest::size() const noexcept -> size_t
+{
+	return keys.empty() ? 0 : keys.size() - 1;
+}
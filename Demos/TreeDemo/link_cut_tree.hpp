@@ -0,0 +1,341 @@
+#pragma once
+
+#include "tree.hpp"
+
+/*
+ * link cut tree is a forest of rooted trees that supports link, cut and path queries in amortized O(log n)
+ * the tree is split into preferred paths, every path is kept in a splay tree ordered by depth
+ * left/right : the children in splay tree, the left subtree is the part of path that is above node
+ * parent : the father in splay tree, or the father of the top of path if node is the root of splay tree
+ * the trees are never rerooted, so the father of node is the same as tree and no lazy reverse is needed.
+ */
+
+template<typename Aggregate = xor_aggregate>
+class link_cut_tree {
+public:
+	using value_type = typename Aggregate::value_type;
+
+	struct node_type {
+		int key = 0;
+		int left = 0, right = 0, parent = 0;
+
+		value_type value = Aggregate::identity();
+	};
+public:
+	explicit link_cut_tree(size_t size);
+
+	// the roots of tree are the roots of link cut tree, the virtual root is not linked
+	explicit link_cut_tree(const tree& tree);
+
+	// same as tree::insert, child is cut from its father before it is linked
+	void insert(int father, int child);
+
+	// link the root of tree child_root to father, return false if father is in the tree of child_root
+	bool link(int father, int child_root);
+
+	// cut the node from its father, node becomes a root
+	void cut(int node);
+
+	// 0 if node is a root
+	int father(int node);
+
+	int find_root(int node);
+
+	bool connected(int node0, int node1);
+
+	// the lowest common ancestor of two nodes, 0 if they are not connected
+	int lca(int node0, int node1);
+
+	// the aggregate of keys on the path from the root to node
+	auto path_value(int node) -> value_type;
+
+	// the aggregate of keys on the path between two nodes, identity if they are not connected
+	auto path_value(int node0, int node1) -> value_type;
+
+	void set_key(int node, int key);
+
+	int key(int node) const;
+
+	auto size() const noexcept -> size_t;
+private:
+	bool is_splay_root(int node) const;
+
+	void update(int node);
+
+	void rotate(int node);
+
+	void splay(int node);
+
+	// make the path from root to node preferred, node becomes the root of its splay tree
+	// return the last node that joined the path, it is the lca of node and the node accessed before
+	int access(int node);
+
+	void shift_to_fit(size_t target);
+private:
+	// 0 indicate the empty node
+	std::vector<node_type> mNodes;
+};
+
+template<typename Aggregate>
+link_cut_tree<Aggregate>::link_cut_tree(size_t size)
+{
+	mNodes = std::vector<node_type>(size + 1);
+
+	for (size_t index = 1; index < mNodes.size(); index++) {
+		mNodes[index].key = static_cast<int>(index);
+		mNodes[index].value = Aggregate::make(mNodes[index].key);
+	}
+}
+
+template<typename Aggregate>
+link_cut_tree<Aggregate>::link_cut_tree(const tree& tree)
+{
+	mNodes = std::vector<node_type>(tree.nodes.size());
+
+	// every node is a path with one node, so the father of node is the parent of it
+	for (size_t index = 1; index < mNodes.size(); index++) {
+		mNodes[index].key = tree.nodes[index].key;
+		mNodes[index].value = Aggregate::make(mNodes[index].key);
+		mNodes[index].parent = std::max(tree.nodes[index].father, 0);
+	}
+}
+
+template<typename Aggregate>
+void link_cut_tree<Aggregate>::insert(int father, int child)
+{
+	shift_to_fit(std::max(father, child) + 1);
+
+	cut(child);
+
+	if (father > 0) link(father, child);
+}
+
+template<typename Aggregate>
+bool link_cut_tree<Aggregate>::link(int father, int child_root)
+{
+	shift_to_fit(std::max(father, child_root) + 1);
+
+	if (father <= 0 || find_root(father) == child_root) return false;
+
+	access(child_root);
+
+	// child_root should be a root, so it is the top of its path
+	if (mNodes[child_root].left != 0) return false;
+
+	mNodes[child_root].parent = father;
+
+	return true;
+}
+
+template<typename Aggregate>
+void link_cut_tree<Aggregate>::cut(int node)
+{
+	access(node);
+
+	const auto left = mNodes[node].left;
+
+	if (left == 0) return;
+
+	mNodes[left].parent = 0;
+	mNodes[node].left = 0;
+
+	update(node);
+}
+
+template<typename Aggregate>
+int link_cut_tree<Aggregate>::father(int node)
+{
+	access(node);
+
+	// the father is the deepest node above node, the max of left subtree
+	auto current = mNodes[node].left;
+
+	if (current == 0) return 0;
+
+	while (mNodes[current].right != 0) current = mNodes[current].right;
+
+	splay(current);
+
+	return current;
+}
+
+template<typename Aggregate>
+int link_cut_tree<Aggregate>::find_root(int node)
+{
+	access(node);
+
+	while (mNodes[node].left != 0) node = mNodes[node].left;
+
+	// keep the amortized bound, the walk above may be long
+	splay(node);
+
+	return node;
+}
+
+template<typename Aggregate>
+bool link_cut_tree<Aggregate>::connected(int node0, int node1)
+{
+	return find_root(node0) == find_root(node1);
+}
+
+template<typename Aggregate>
+int link_cut_tree<Aggregate>::lca(int node0, int node1)
+{
+	if (!connected(node0, node1)) return 0;
+
+	access(node0);
+
+	return access(node1);
+}
+
+template<typename Aggregate>
+auto link_cut_tree<Aggregate>::path_value(int node) -> value_type
+{
+	access(node);
+
+	// the splay tree of node holds the path from root to node
+	return mNodes[node].value;
+}
+
+template<typename Aggregate>
+auto link_cut_tree<Aggregate>::path_value(int node0, int node1) -> value_type
+{
+	const auto ancestor = lca(node0, node1);
+
+	if (ancestor == 0) return Aggregate::identity();
+
+	// the right subtree of ancestor is the part of path below ancestor
+	access(node0);
+	splay(ancestor);
+
+	const auto value0 = mNodes[mNodes[ancestor].right].value;
+
+	access(node1);
+	splay(ancestor);
+
+	const auto value1 = mNodes[mNodes[ancestor].right].value;
+
+	return Aggregate::combine(Aggregate::combine(value0, Aggregate::make(mNodes[ancestor].key)), value1);
+}
+
+template<typename Aggregate>
+void link_cut_tree<Aggregate>::set_key(int node, int key)
+{
+	shift_to_fit(node + 1);
+
+	access(node);
+
+	mNodes[node].key = key;
+
+	update(node);
+}
+
+template<typename Aggregate>
+int link_cut_tree<Aggregate>::key(int node) const
+{
+	return mNodes[node].key;
+}
+
+template<typename Aggregate>
+auto link_cut_tree<Aggregate>::size() const noexcept -> size_t
+{
+	return mNodes.size() - 1;
+}
+
+template<typename Aggregate>
+bool link_cut_tree<Aggregate>::is_splay_root(int node) const
+{
+	const auto parent = mNodes[node].parent;
+
+	return parent == 0 || (mNodes[parent].left != node && mNodes[parent].right != node);
+}
+
+template<typename Aggregate>
+void link_cut_tree<Aggregate>::update(int node)
+{
+	auto& current = mNodes[node];
+
+	// the value of empty node is identity, so the empty children need not be checked
+	current.value = Aggregate::combine(
+		Aggregate::combine(mNodes[current.left].value, Aggregate::make(current.key)),
+		mNodes[current.right].value);
+}
+
+template<typename Aggregate>
+void link_cut_tree<Aggregate>::rotate(int node)
+{
+	const auto parent = mNodes[node].parent;
+	const auto grand = mNodes[parent].parent;
+
+	if (!is_splay_root(parent)) {
+		if (mNodes[grand].left == parent) mNodes[grand].left = node;
+		else mNodes[grand].right = node;
+	}
+
+	if (mNodes[parent].left == node) {
+		mNodes[parent].left = mNodes[node].right;
+		mNodes[node].right = parent;
+
+		if (mNodes[parent].left != 0) mNodes[mNodes[parent].left].parent = parent;
+	}
+	else {
+		mNodes[parent].right = mNodes[node].left;
+		mNodes[node].left = parent;
+
+		if (mNodes[parent].right != 0) mNodes[mNodes[parent].right].parent = parent;
+	}
+
+	mNodes[parent].parent = node;
+	mNodes[node].parent = grand;
+
+	update(parent);
+	update(node);
+}
+
+template<typename Aggregate>
+void link_cut_tree<Aggregate>::splay(int node)
+{
+	while (!is_splay_root(node)) {
+		const auto parent = mNodes[node].parent;
+
+		if (!is_splay_root(parent)) {
+			const auto grand = mNodes[parent].parent;
+			const auto zigzig = (mNodes[grand].left == parent) == (mNodes[parent].left == node);
+
+			rotate(zigzig ? parent : node);
+		}
+
+		rotate(node);
+	}
+}
+
+template<typename Aggregate>
+int link_cut_tree<Aggregate>::access(int node)
+{
+	auto last = 0;
+
+	for (auto current = node; current != 0; current = mNodes[current].parent) {
+		splay(current);
+
+		mNodes[current].right = last;
+
+		update(current);
+
+		last = current;
+	}
+
+	splay(node);
+
+	return last;
+}
+
+template<typename Aggregate>
+void link_cut_tree<Aggregate>::shift_to_fit(size_t target)
+{
+	for (auto index = mNodes.size(); index < target; index++) {
+		mNodes.push_back(node_type());
+
+		mNodes[index].key = static_cast<int>(index);
+		mNodes[index].value = Aggregate::make(mNodes[index].key);
+	}
+}
@@ -87,7 +87,7 @@ namespace tree_info {
 		if (global_mode == mode::tree) {
 			if (!has_tree()) return false;
 
-			return global_tree->nodes[0].children.find(node) != global_tree->nodes[0].children.end();
+			return legal_node(node) && global_tree->nodes[node].father == 0;
 		}
 
 		if (global_mode == mode::binary_tree) {
@@ -255,10 +255,12 @@ void build_command(
 			return;
 		}
 
-		global_tree = std::make_shared<tree>(std::stoi(arguments[2]), std::vector<int>());
+		std::vector<int> roots(std::stoi(arguments[2]));
 
-		for (int index = 1; index < global_tree->nodes.size(); index++)
-			global_tree->nodes[0].children.insert(index);
+		for (size_t index = 0; index < roots.size(); index++)
+			roots[index] = static_cast<int>(index) + 1;
+
+		global_tree = std::make_shared<tree>(roots.size(), roots);
 
 		global_mode = mode::tree;
 
@@ -304,6 +306,7 @@ void build_command(
 		}
 
 		global_binary_tree->nodes[root_of_tree].brother = 1;
+		global_binary_tree->rebuild();
 		
 		global_mode = mode::binary_tree;
 
@@ -343,7 +346,10 @@ void transform_command(
 			return;
 		}
 
-		global_binary_tree = global_tree->to_binary_tree();
+		// reuse the buffers of the last transform
+		if (global_binary_tree == nullptr) global_binary_tree = std::make_shared<binary_tree>(0, 0);
+
+		global_tree->to_binary_tree(*global_binary_tree);
 
 		global_mode = mode::binary_tree;
 		
@@ -356,7 +362,9 @@ void transform_command(
 			return;
 		}
 
-		global_tree = global_binary_tree->to_tree();
+		if (global_tree == nullptr) global_tree = std::make_shared<tree>(0, std::vector<int>());
+
+		global_binary_tree->to_tree(*global_tree);
 
 		global_mode = mode::tree;
 	}
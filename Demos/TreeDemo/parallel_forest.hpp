@@ -0,0 +1,289 @@
+#pragma once
+
+#include "tree.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <deque>
+
+/*
+ * parallel traversal of forest, every root is a task of work stealing pool
+ * a task walks its subtree with an explicit stack, after every grain nodes it gives the bottom half of
+ * its stack(the nodes near the root, usually the larger subtrees) to the pool as new tasks.
+ * the partial results of tasks are combined into the result of their root, so combine should be
+ * associative and commutative like the aggregates of subtree.
+ */
+
+class work_stealing_pool final {
+public:
+	// threads = 0 means all hardware threads
+	explicit work_stealing_pool(size_t threads = 0);
+
+	~work_stealing_pool();
+
+	work_stealing_pool(const work_stealing_pool&) = delete;
+
+	work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+	// the task is pushed to the queue of current worker, or a queue chosen in turn for other threads
+	void submit(std::function<void()> task);
+
+	// run tasks on the calling thread until pending is 0
+	void wait(const std::atomic<size_t>& pending);
+
+	auto size() const noexcept -> size_t;
+private:
+	struct task_queue {
+		std::mutex mutex;
+
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void work(size_t index);
+
+	// pop a task from the back of own queue or steal one from the front of others
+	bool run_one(size_t index);
+private:
+	// the last queue is used by the threads that are not workers
+	std::vector<std::unique_ptr<task_queue>> mQueues;
+	std::vector<std::thread> mWorkers;
+
+	std::atomic<size_t> mQueued;
+	std::atomic<size_t> mNext;
+	std::atomic<bool> mStop;
+
+	std::mutex mSleepMutex;
+	std::condition_variable mSleep;
+
+	// the pool and the index of queue of current thread
+	static thread_local const work_stealing_pool* tPool;
+	static thread_local size_t tIndex;
+};
+
+inline thread_local const work_stealing_pool* work_stealing_pool::tPool = nullptr;
+inline thread_local size_t work_stealing_pool::tIndex = 0;
+
+inline work_stealing_pool::work_stealing_pool(size_t threads) :
+	mQueued(0), mNext(0), mStop(false)
+{
+	if (threads == 0) threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+	for (size_t index = 0; index <= threads; index++)
+		mQueues.push_back(std::make_unique<task_queue>());
+
+	for (size_t index = 0; index < threads; index++)
+		mWorkers.push_back(std::thread([this, index]() { work(index); }));
+}
+
+inline work_stealing_pool::~work_stealing_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+
+		mStop = true;
+	}
+
+	mSleep.notify_all();
+
+	for (auto& worker : mWorkers) worker.join();
+}
+
+inline void work_stealing_pool::submit(std::function<void()> task)
+{
+	const auto index = tPool == this ? tIndex : mNext.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+
+	// count the task before it is visible, so the count is never less than the number of tasks in queues
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+
+		mQueued++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mQueues[index]->mutex);
+
+		mQueues[index]->tasks.push_back(std::move(task));
+	}
+
+	mSleep.notify_one();
+}
+
+inline void work_stealing_pool::wait(const std::atomic<size_t>& pending)
+{
+	const auto index = tPool == this ? tIndex : mQueues.size() - 1;
+
+	while (pending.load() != 0) {
+		if (!run_one(index)) std::this_thread::yield();
+	}
+}
+
+inline auto work_stealing_pool::size() const noexcept -> size_t
+{
+	return mWorkers.size();
+}
+
+inline void work_stealing_pool::work(size_t index)
+{
+	tPool = this;
+	tIndex = index;
+
+	while (true) {
+		if (run_one(index)) continue;
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+
+		mSleep.wait(lock, [this]() { return mStop || mQueued != 0; });
+
+		if (mStop) return;
+	}
+}
+
+inline bool work_stealing_pool::run_one(size_t index)
+{
+	std::function<void()> task;
+
+	for (size_t offset = 0; offset < mQueues.size() && !task; offset++) {
+		auto& queue = *mQueues[(index + offset) % mQueues.size()];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.tasks.empty()) continue;
+
+		// own tasks are taken in LIFO order for locality, stolen tasks in FIFO order since they are larger
+		if (offset == 0) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+
+	if (!task) return false;
+
+	mQueued--;
+
+	task();
+
+	return true;
+}
+
+// reduce the nodes of each tree, expand(node, push) calls push(child) for the children of node
+// map(node) is the value of node, return the result of each root
+template<typename Value, typename Expand, typename Map, typename Combine>
+auto parallel_reduce(work_stealing_pool& pool, const std::vector<int>& roots, size_t grain,
+	const Value& identity, const Expand& expand, const Map& map, const Combine& combine) -> std::vector<Value>
+{
+	// the caller may return as soon as pending is 0, while the task that decreased it is still returning
+	// so every task holds the shared state and the decrease of pending is the last use of the caller's data
+	struct reduce_state {
+		std::vector<Value> results;
+		std::vector<std::mutex> locks;
+		std::atomic<size_t> pending;
+
+		std::function<void(const std::shared_ptr<reduce_state>&, size_t, int)> reduce;
+
+		reduce_state(size_t size, const Value& identity) : results(size, identity), locks(size), pending(0) {}
+	};
+
+	const auto state = std::make_shared<reduce_state>(roots.size(), identity);
+
+	grain = std::max<size_t>(grain, 1);
+
+	// the task reduces the subtree of node into the result of root
+	state->reduce = [&pool, &identity, &expand, &map, &combine, grain](
+		const std::shared_ptr<reduce_state>& state, size_t root, int node) {
+		auto value = identity;
+
+		std::vector<int> stack = { node };
+
+		size_t visited = 0;
+
+		while (!stack.empty()) {
+			const auto current = stack.back();
+
+			stack.pop_back();
+
+			value = combine(value, map(current));
+
+			expand(current, [&](int child) { stack.push_back(child); });
+
+			if (++visited % grain != 0 || stack.size() < 2) continue;
+
+			const auto half = stack.size() / 2;
+
+			state->pending += half;
+
+			for (size_t index = 0; index < half; index++) {
+				const auto child = stack[index];
+
+				pool.submit([state, root, child]() { state->reduce(state, root, child); });
+			}
+
+			stack.erase(stack.begin(), stack.begin() + half);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(state->locks[root]);
+
+			state->results[root] = combine(state->results[root], value);
+		}
+
+		state->pending--;
+	};
+
+	state->pending += roots.size();
+
+	for (size_t index = 0; index < roots.size(); index++) {
+		const auto root = roots[index];
+
+		pool.submit([state, index, root]() { state->reduce(state, index, root); });
+	}
+
+	pool.wait(state->pending);
+
+	return std::move(state->results);
+}
+
+// the aggregate of every tree in the order of nodes[0].children
+template<typename Aggregate>
+auto parallel_aggregate(const tree& tree, work_stealing_pool& pool, size_t grain = 4096)
+	-> std::vector<typename Aggregate::value_type>
+{
+	const std::vector<int> roots(tree.nodes[0].children.begin(), tree.nodes[0].children.end());
+
+	return parallel_reduce(pool, roots, grain, Aggregate::identity(),
+		[&](int node, const auto& push) { for (const auto& child : tree.nodes[node].children) push(child); },
+		[&](int node) { return Aggregate::make(tree.nodes[node].key); },
+		[](const auto& lhs, const auto& rhs) { return Aggregate::combine(lhs, rhs); });
+}
+
+// the aggregate of the nodes linked with root, 0 is the empty node
+template<typename Aggregate>
+auto parallel_aggregate(const binary_tree& tree, work_stealing_pool& pool, size_t grain = 4096)
+	-> typename Aggregate::value_type
+{
+	if (tree.root == 0) return Aggregate::identity();
+
+	return parallel_reduce(pool, std::vector<int>{ tree.root }, grain, Aggregate::identity(),
+		[&](int node, const auto& push) {
+			if (tree.nodes[node].child != 0) push(tree.nodes[node].child);
+			if (tree.nodes[node].brother != 0) push(tree.nodes[node].brother);
+		},
+		[&](int node) { return Aggregate::make(tree.nodes[node].key); },
+		[](const auto& lhs, const auto& rhs) { return Aggregate::combine(lhs, rhs); })[0];
+}
+
+// the same output as tree::print, the xor of every tree is computed in parallel
+inline void parallel_print(const tree& tree, work_stealing_pool& pool, size_t grain = 4096)
+{
+	for (const auto& value : parallel_aggregate<xor_aggregate>(tree, pool, grain))
+		std::cout << value << " ";
+
+	std::cout << std::endl;
+}
@@ -2,18 +2,47 @@
 
 #include <algorithm>
 #include <iostream>
+#include <unordered_map>
+#include <limits>
 #include <vector>
 #include <memory>
+#include <utility>
+
+/*
+ * the children of tree node are kept in child_set by default, so the i-th child and the rank of a child are O(log d)
+ * define TREE_CHILDREN_STD_SET to keep them in std::set<int> instead, every child is a heap node and the rank and
+ * select of children are O(d) then, but the iterators of children are not invalidated by insert or erase
+ */
+
+#ifdef TREE_CHILDREN_STD_SET
+#include <iterator>
 #include <set>
 
+using tree_children = std::set<int>;
+#else
+#include "child_set.hpp"
+
+using tree_children = child_set;
+#endif
+
 struct tree_node {
 	int key = 0;
 
-	std::set<int> children;
+	// 0 indicate the virtual root, -1 indicate the node is not in any tree
+	int father = -1;
+
+	// sorted in ascending order
+	tree_children children;
 
 	tree_node() = default;
 
 	tree_node(const int key) : key(key) {}
+
+	// the number of children less than child
+	auto child_rank(int child) const -> size_t;
+
+	// the index-th child in ascending order, index should be less than children.size()
+	auto child_select(size_t index) const -> int;
 };
 
 struct binary_tree_node {
@@ -25,33 +54,198 @@ struct binary_tree_node {
 		key(key), child(child), brother(brother) {}
 };
 
+/*
+ * aggregates of subtree, combine should be associative and commutative
+ */
+
+struct xor_aggregate {
+	using value_type = int;
+
+	static value_type identity() { return 0; }
+
+	static value_type make(int key) { return key; }
+
+	static value_type combine(value_type lhs, value_type rhs) { return lhs ^ rhs; }
+};
+
+struct sum_aggregate {
+	using value_type = long long;
+
+	static value_type identity() { return 0; }
+
+	static value_type make(int key) { return key; }
+
+	static value_type combine(value_type lhs, value_type rhs) { return lhs + rhs; }
+};
+
+struct count_aggregate {
+	using value_type = long long;
+
+	static value_type identity() { return 0; }
+
+	static value_type make(int) { return 1; }
+
+	static value_type combine(value_type lhs, value_type rhs) { return lhs + rhs; }
+};
+
+struct min_aggregate {
+	using value_type = int;
+
+	static value_type identity() { return std::numeric_limits<int>::max(); }
+
+	static value_type make(int key) { return key; }
+
+	static value_type combine(value_type lhs, value_type rhs) { return std::min(lhs, rhs); }
+};
+
 class binary_tree;
 class tree;
 
+// the events of tree, they are called after the tree is changed
+class tree_listener {
+public:
+	virtual ~tree_listener() = default;
+
+	// the subtree of node is attached to nodes[node].father
+	virtual void on_attach(const tree& tree, int node) = 0;
+
+	// the subtree of node is detached from old_father
+	virtual void on_detach(const tree& tree, int node, int old_father) = 0;
+
+	// the key of node is changed
+	virtual void on_key(const tree& tree, int node, int old_key) = 0;
+
+	// new nodes are pushed to the end of nodes
+	virtual void on_grow(const tree& tree) = 0;
+
+	// the nodes are changed without events
+	virtual void on_reset(const tree& tree) = 0;
+};
+
+template<typename Aggregate>
+class subtree_aggregate;
+
 class tree {
 public:
 	tree(size_t size, const std::vector<int>& roots);
 
+	tree(const tree&) = delete;
+
+	tree& operator=(const tree&) = delete;
+
 	void insert(int father, int child);
 
+	// insert a node with a recycled id(or a new id if there is no removed node), return the id
+	int insert(int father);
+
 	void remove(int father, int child);
 
 	void link(int father_root, int child_root);
 
+	// the xor of keys in the tree of every root, read from the xor aggregate of tree
+	// only the nodes changed since the last print are recomputed, so print is O(number of roots) without changes
 	void print();
 
 	bool in(int node);
+
+	// the root of tree that node belongs to, -1 if node is not in any tree
+	// near-constant while the trees only grow, the first lookup after a subtree is moved walks the fathers again
+	int root(int node);
+
+	// recompute the fathers from children, call it after modifying nodes directly
+	void rebuild();
+
+	// renumber the nodes in trees densely in ascending order and drop the others
+	// return the new id of every old id, -1 if the node is dropped
+	auto compact()->std::vector<int>;
+
+	// the listener is called after every change of tree, the tree keeps it alive
+	void add_listener(const std::shared_ptr<tree_listener>& listener);
+
+	// maintain the aggregate of every subtree incrementally, a change marks the changed node and its ancestors
+	// and a value is recomputed from the marked nodes when it is read
+	template<typename Aggregate>
+	auto add_aggregate()->std::shared_ptr<const subtree_aggregate<Aggregate>>;
+
+	// iterative traversals of the subtree of node, visitor(node) is called for each node
+	template<typename Visitor>
+	void preorder(int node, Visitor&& visitor) const;
+
+	template<typename Visitor>
+	void postorder(int node, Visitor&& visitor) const;
+
+	template<typename Visitor>
+	void levelorder(int node, Visitor&& visitor) const;
 	
 	auto to_binary_tree()->std::shared_ptr<binary_tree>;
+
+	// convert in one pass, the buffers of output are reused
+	void to_binary_tree(binary_tree& output) const;
 public:
 	// 0 indicate the virtual root
 	std::vector<tree_node> nodes;
 private:
-	void search(int node, int& output);
+	void attach(int father, int child);
+
+	void detach(int child);
+
+	void set_key(int node, int key);
 
-	bool search_in(int node, int target);
+	int find_set(int node);
+
+	// reset the pointer of node to its father if the pointer is set before the current epoch
+	void refresh_set(int node);
 	
 	void shift_to_fit(size_t target);
+private:
+	// disjoint set of nodes, the representative of set is the top node(a root or a node not in tree)
+	// a node of set only points to its ancestors, but a union-find can not split a set
+	// so a node that leaves its father starts a new epoch in O(1) instead of walking its subtree
+	// a pointer set in an old epoch may skip the node that left, so it is reset to the father when it is followed
+	std::vector<int> mSets;
+	std::vector<size_t> mSetEpochs;
+
+	size_t mEpoch = 1;
+
+	std::vector<std::shared_ptr<tree_listener>> mListeners;
+
+	// the xor of keys in every subtree, it is one of the listeners
+	std::shared_ptr<const subtree_aggregate<xor_aggregate>> mXor;
+
+	// the removed nodes, an id may be inserted again by user, so it is checked when it is popped
+	std::vector<int> mFree;
+};
+
+template<typename Aggregate>
+class subtree_aggregate final : public tree_listener {
+public:
+	using value_type = typename Aggregate::value_type;
+public:
+	// the aggregate reads tree when a value is recomputed, so it is valid while tree is alive
+	explicit subtree_aggregate(const tree& tree);
+
+	// O(1) if node is not marked, otherwise O(the marked nodes in the subtree of node and their children)
+	auto value(int node) const -> value_type;
+
+	void on_attach(const tree& tree, int node) override;
+
+	void on_detach(const tree& tree, int node, int old_father) override;
+
+	void on_key(const tree& tree, int node, int old_key) override;
+
+	void on_grow(const tree& tree) override;
+
+	void on_reset(const tree& tree) override;
+private:
+	// mark node and its ancestors, the marking stops at the first marked node
+	void mark(const tree& tree, int node);
+private:
+	const tree& mTree;
+
+	// the value of a marked node is out of date, the ancestors of a marked node are marked
+	// so the nodes that are not marked have the values of their whole subtrees
+	mutable std::vector<value_type> mValues;
+	mutable std::vector<bool> mMarks;
 };
 
 class binary_tree {
@@ -60,29 +254,102 @@ public:
 
 	void insert(int father, int left_child, int right_child);
 
+	// append child to the children of father for each edge(father, child)
+	void insert_many(const std::vector<std::pair<int, int>>& edges);
+
+	// the xor of the keys visited by the preorder from root, a node linked twice is visited twice
+	// the values of nodes are kept, so print only recomputes the nodes changed since the last print
 	void print();
 
+	// reset the hints of brother chains and the values of print, call it after modifying nodes directly
+	void rebuild();
+
 	auto to_tree()->std::shared_ptr<tree>;
+
+	// convert in two passes, the nodes of output are reused and the children are appended in order
+	void to_tree(tree& output) const;
+
+	// iterative traversals with child as left and brother as right, visitor(node) is called for each node
+	template<typename Visitor>
+	void preorder(int node, Visitor&& visitor) const;
+
+	template<typename Visitor>
+	void postorder(int node, Visitor&& visitor) const;
+
+	template<typename Visitor>
+	void levelorder(int node, Visitor&& visitor) const;
 public:
 	std::vector<binary_tree_node> nodes;
 
 	int root;
 
 private:
-	void search(const int node, int& output);
+	// the last node of the brother chain that node is in
+	int last_brother(int node);
+
+	void set_key(int node, int key);
+
+	// node links to target as its child or brother
+	void add_link(int node, int target);
+
+	// mark node and the nodes linking to it, their values are recomputed by the next print
+	void invalidate(int node);
+
+	// the xor of the keys visited by the preorder from node, the marked nodes are recomputed in post-order
+	int value(int node);
 
 	void shift_to_fit(size_t target);
+private:
+	// a node at or after node in its brother chain, the chains only grow at the end
+	// so the hints are compressed like the disjoint set and appending is amortized O(1)
+	std::vector<int> mTails;
+
+	// the value of node is its key xor the values of its child and brother, it is out of date if node is marked
+	// a marked node has marked the nodes linking to it, so marking stops at the first marked node
+	std::vector<int> mValues;
+	std::vector<bool> mMarks;
+
+	// the first node linking to node(0 if none), a node linked twice keeps the other nodes in mMoreLinks
+	std::vector<int> mLinks;
+	std::unordered_multimap<int, int> mMoreLinks;
 };
 
+inline auto tree_node::child_rank(int child) const -> size_t
+{
+#ifdef TREE_CHILDREN_STD_SET
+	return static_cast<size_t>(std::distance(children.begin(), children.lower_bound(child)));
+#else
+	return children.rank(child);
+#endif
+}
+
+inline auto tree_node::child_select(size_t index) const -> int
+{
+#ifdef TREE_CHILDREN_STD_SET
+	return *std::next(children.begin(), static_cast<std::ptrdiff_t>(index));
+#else
+	return children.select(index);
+#endif
+}
+
 inline tree::tree(size_t size, const std::vector<int>& roots)
 {
 	nodes = std::vector<tree_node>(size + 1);
 
-	for (size_t index = 0; index < nodes.size(); index++)
+	mSets = std::vector<int>(size + 1);
+	mSetEpochs = std::vector<size_t>(size + 1, mEpoch);
+
+	for (size_t index = 0; index < nodes.size(); index++) {
 		nodes[index].key = static_cast<int>(index);
 
+		mSets[index] = static_cast<int>(index);
+	}
+
 	for (size_t index = 0; index < roots.size(); index++)
-		nodes[0].children.insert(roots[index]);
+		attach(0, roots[index]);
+
+	// built once from the roots, then it is updated by the events of tree
+	mXor = add_aggregate<xor_aggregate>();
 }
 
 inline void tree::insert(int father, int child)
@@ -91,108 +358,440 @@ inline void tree::insert(int father, int child)
 
 	shift_to_fit(std::max(father, child) + 1);
 
-	nodes[father].key = father;
-	nodes[child].key = child;
+	set_key(father, father);
+	set_key(child, child);
 
-	nodes[father].children.insert(child);
+	attach(father, child);
+}
+
+inline int tree::insert(int father)
+{
+	while (!mFree.empty()) {
+		const auto node = mFree.back();
+
+		mFree.pop_back();
+
+		if (node < static_cast<int>(nodes.size()) && nodes[node].key == -1 && nodes[node].father == -1) {
+			insert(father, node);
+
+			return node;
+		}
+	}
+
+	const auto node = static_cast<int>(nodes.size());
+
+	insert(father, node);
+
+	return node;
 }
 
 inline void tree::remove(int father, int child)
 {
 	if (father == -1) father = 0;
 
-	for (const auto& new_root : nodes[child].children)
-		nodes[0].children.insert(new_root);
+	while (!nodes[child].children.empty())
+		attach(0, *nodes[child].children.begin());
+
+	if (nodes[child].father == father) detach(child);
 
-	nodes[child].children.clear();
-	nodes[child].key = -1;
+	set_key(child, -1);
 
-	nodes[father].children.erase(child);
+	mFree.push_back(child);
 }
 
 inline void tree::link(int father_root, int child_root)
 {
 	shift_to_fit(std::max(father_root, child_root) + 1);
 
-	nodes[father_root].key = father_root;
-	nodes[child_root].key = child_root;
+	set_key(father_root, father_root);
+	set_key(child_root, child_root);
 
-	nodes[0].children.erase(child_root);
-	nodes[father_root].children.insert(child_root);
+	attach(father_root, child_root);
 }
 
 inline void tree::print() {
-	for (const auto& child : nodes[0].children) {
-		int output = 0;
+	for (const auto& child : nodes[0].children)
+		std::cout << mXor->value(child) << " ";
+
+	std::cout << std::endl;
+}
+
+inline bool tree::in(int node)
+{
+	return node == 0 || root(node) != -1;
+}
+
+inline int tree::root(int node)
+{
+	if (node <= 0 || node >= static_cast<int>(nodes.size())) return -1;
+
+	const auto top = find_set(node);
 
-		search(child, output);
+	return nodes[top].father == 0 ? top : -1;
+}
 
-		std::cout << output << " ";
+inline void tree::rebuild()
+{
+	for (auto& node : nodes) node.father = -1;
+
+	for (size_t index = 0; index < nodes.size(); index++) {
+		for (const auto& child : nodes[index].children)
+			nodes[child].father = static_cast<int>(index);
 	}
 
-	std::cout << std::endl;
+	// the pointers of the old epochs are reset from the new fathers when they are followed
+	mSets.resize(nodes.size());
+	mSetEpochs.resize(nodes.size(), 0);
+	mEpoch++;
+
+	for (const auto& listener : mListeners) listener->on_reset(*this);
 }
 
-inline bool tree::in(int node)
+inline void tree::add_listener(const std::shared_ptr<tree_listener>& listener)
+{
+	mListeners.push_back(listener);
+}
+
+inline auto tree::compact() -> std::vector<int>
+{
+	std::vector<int> remap(nodes.size(), -1);
+
+	auto count = 0;
+
+	for (size_t index = 0; index < nodes.size(); index++) {
+		if (index == 0 || nodes[index].father != -1) remap[index] = count++;
+	}
+
+	// remap[index] <= index, so the target slot is dropped or its node is moved before
+	for (size_t index = 0; index < nodes.size(); index++) {
+		if (remap[index] == -1) continue;
+
+		tree_children children;
+
+		// remap keeps the order of ids, so the children are still ascending
+		for (const auto& child : nodes[index].children)
+			children.insert(children.end(), remap[child]);
+
+		auto& target = nodes[remap[index]];
+
+		target.children = std::move(children);
+
+		// the key of node in tree is its id
+		target.key = remap[index];
+	}
+
+	nodes.resize(count);
+	mFree.clear();
+
+	rebuild();
+
+	return remap;
+}
+
+template<typename Aggregate>
+auto tree::add_aggregate() -> std::shared_ptr<const subtree_aggregate<Aggregate>>
 {
-	return search_in(0, node);
+	auto aggregate = std::make_shared<subtree_aggregate<Aggregate>>(*this);
+
+	add_listener(aggregate);
+
+	return aggregate;
 }
 
 inline auto tree::to_binary_tree() -> std::shared_ptr<binary_tree>
 {
-	auto tree = std::make_shared<binary_tree>(nodes.size() - 1, *nodes[0].children.begin());
+	auto tree = std::make_shared<binary_tree>(0, 0);
 
-	for (size_t index = 0; index < nodes.size(); index++)
-		tree->nodes[index].key = nodes[index].key;
+	to_binary_tree(*tree);
+
+	return tree;
+}
 
+inline void tree::to_binary_tree(binary_tree& output) const
+{
+	output.nodes.resize(nodes.size());
+	output.root = nodes[0].children.empty() ? 0 : *nodes[0].children.begin();
+
+	// the roots are the brothers of the first root
 	for (size_t index = 0; index < nodes.size(); index++) {
-		if (nodes[index].children.empty()) continue;
+		const auto& children = nodes[index].children;
+
+		output.nodes[index].key = nodes[index].key;
+		output.nodes[index].child = children.empty() ? 0 : *children.begin();
 
-		tree->nodes[index].child = *nodes[index].children.begin();
+		// the brother of a child is set by its father, a node without father has no brother
+		if (nodes[index].father == -1) output.nodes[index].brother = 0;
 
-		for (auto it = nodes[index].children.begin(); it != nodes[index].children.end(); ++it) {
-			auto next_it = it; ++next_it;
+		for (auto it = children.begin(); it != children.end();) {
+			const auto child = *it;
 
-			if (next_it != nodes[index].children.end())
-				tree->nodes[*it].brother = *next_it;
+			output.nodes[child].brother = ++it != children.end() ? *it : 0;
 		}
 	}
 
-	return tree;
+	output.rebuild();
+}
+
+template<typename Visitor>
+void tree::preorder(int node, Visitor&& visitor) const
+{
+	using iterator = tree_children::const_iterator;
+
+	// the ranges of children that are not visited
+	std::vector<std::pair<iterator, iterator>> stack;
+
+	visitor(node);
+
+	stack.push_back({ nodes[node].children.begin(), nodes[node].children.end() });
+
+	while (!stack.empty()) {
+		auto& range = stack.back();
+
+		if (range.first == range.second) {
+			stack.pop_back();
+
+			continue;
+		}
+
+		const auto current = *range.first++;
+
+		visitor(current);
+
+		stack.push_back({ nodes[current].children.begin(), nodes[current].children.end() });
+	}
+}
+
+template<typename Visitor>
+void tree::postorder(int node, Visitor&& visitor) const
+{
+	using iterator = tree_children::const_iterator;
+
+	// the node and the range of its children that are not visited
+	std::vector<std::pair<int, iterator>> stack = { { node, nodes[node].children.begin() } };
+
+	while (!stack.empty()) {
+		auto& top = stack.back();
+
+		if (top.second == nodes[top.first].children.end()) {
+			visitor(top.first);
+
+			stack.pop_back();
+
+			continue;
+		}
+
+		const auto current = *top.second++;
+
+		stack.push_back({ current, nodes[current].children.begin() });
+	}
 }
 
-inline void tree::search(int node, int& output)
+template<typename Visitor>
+void tree::levelorder(int node, Visitor&& visitor) const
 {
-	output = output ^ nodes[node].key;
+	std::vector<int> queue = { node };
 
-	for (const auto& child : nodes[node].children)
-		search(child, output);
+	for (size_t head = 0; head < queue.size(); head++) {
+		visitor(queue[head]);
+
+		for (const auto& child : nodes[queue[head]].children)
+			queue.push_back(child);
+	}
 }
 
-inline bool tree::search_in(int node, int target)
+inline void tree::attach(int father, int child)
 {
-	if (node == target) return true;
+	if (nodes[child].father != -1) detach(child);
+
+	nodes[father].children.insert(child);
+	nodes[child].father = father;
 
-	for (const auto& child : nodes[node].children) 
-		if (search_in(child, target)) return true;
+	// child was a top node, so pointing it to father joins its set to the set of father
+	mSets[child] = father != 0 ? father : child;
+	mSetEpochs[child] = mEpoch;
 
-	return false;
+	for (const auto& listener : mListeners) listener->on_attach(*this, child);
+}
+
+inline void tree::detach(int child)
+{
+	const auto old_father = nodes[child].father;
+
+	nodes[old_father].children.erase(child);
+	nodes[child].father = -1;
+
+	// the pointers in the subtree of child may skip child, a root leaves only the virtual root
+	if (old_father != 0) mEpoch++;
+
+	for (const auto& listener : mListeners) listener->on_detach(*this, child, old_father);
+}
+
+inline void tree::set_key(int node, int key)
+{
+	const auto old_key = nodes[node].key;
+
+	if (old_key == key) return;
+
+	nodes[node].key = key;
+
+	for (const auto& listener : mListeners) listener->on_key(*this, node, old_key);
+}
+
+inline int tree::find_set(int node)
+{
+	refresh_set(node);
+
+	// path halving, a pointer is refreshed before it is followed
+	while (mSets[node] != node) {
+		const auto next = mSets[node];
+
+		refresh_set(next);
+
+		mSets[node] = mSets[next];
+		node = mSets[node];
+
+		refresh_set(node);
+	}
+
+	return node;
+}
+
+inline void tree::refresh_set(int node)
+{
+	if (mSetEpochs[node] == mEpoch) return;
+
+	mSets[node] = nodes[node].father > 0 ? nodes[node].father : node;
+	mSetEpochs[node] = mEpoch;
 }
 
 inline void tree::shift_to_fit(size_t target)
 {
-	for (size_t index = nodes.size(); index < target; index++) {
-		nodes.push_back(tree_node(static_cast<int>(index)));
+	if (nodes.size() >= target) return;
+
+	// grow the capacity geometrically, so inserting ids one by one is amortized O(1)
+	if (target > nodes.capacity()) {
+		const auto capacity = std::max(target, nodes.capacity() * 2);
+
+		nodes.reserve(capacity);
+		mSets.reserve(capacity);
+		mSetEpochs.reserve(capacity);
 	}
+
+	const auto size = nodes.size();
+
+	nodes.resize(target);
+	mSets.resize(target);
+	mSetEpochs.resize(target, mEpoch);
+
+	for (auto index = size; index < target; index++) {
+		nodes[index].key = static_cast<int>(index);
+
+		mSets[index] = static_cast<int>(index);
+	}
+
+	for (const auto& listener : mListeners) listener->on_grow(*this);
+}
+
+template<typename Aggregate>
+subtree_aggregate<Aggregate>::subtree_aggregate(const tree& tree) : mTree(tree)
+{
+	on_reset(tree);
+}
+
+template<typename Aggregate>
+auto subtree_aggregate<Aggregate>::value(int node) const -> value_type
+{
+	using iterator = tree_children::const_iterator;
+
+	if (!mMarks[node]) return mValues[node];
+
+	// recompute the marked nodes in post-order, the children that are not marked are not visited
+	std::vector<std::pair<int, iterator>> stack = { { node, mTree.nodes[node].children.begin() } };
+
+	while (!stack.empty()) {
+		auto& top = stack.back();
+
+		if (top.second != mTree.nodes[top.first].children.end()) {
+			const auto child = *top.second++;
+
+			if (mMarks[child]) stack.push_back({ child, mTree.nodes[child].children.begin() });
+
+			continue;
+		}
+
+		auto value = Aggregate::make(mTree.nodes[top.first].key);
+
+		for (const auto& child : mTree.nodes[top.first].children)
+			value = Aggregate::combine(value, mValues[child]);
+
+		mValues[top.first] = value;
+		mMarks[top.first] = false;
+
+		stack.pop_back();
+	}
+
+	return mValues[node];
+}
+
+template<typename Aggregate>
+void subtree_aggregate<Aggregate>::on_attach(const tree& tree, int node)
+{
+	mark(tree, tree.nodes[node].father);
+}
+
+template<typename Aggregate>
+void subtree_aggregate<Aggregate>::on_detach(const tree& tree, int, int old_father)
+{
+	mark(tree, old_father);
+}
+
+template<typename Aggregate>
+void subtree_aggregate<Aggregate>::on_key(const tree& tree, int node, int)
+{
+	mark(tree, node);
+}
+
+template<typename Aggregate>
+void subtree_aggregate<Aggregate>::on_grow(const tree& tree)
+{
+	for (auto index = mValues.size(); index < tree.nodes.size(); index++) {
+		mValues.push_back(Aggregate::make(tree.nodes[index].key));
+		mMarks.push_back(false);
+	}
+}
+
+template<typename Aggregate>
+void subtree_aggregate<Aggregate>::on_reset(const tree& tree)
+{
+	// every node is marked, so the values are recomputed when they are read
+	mValues.assign(tree.nodes.size(), Aggregate::identity());
+	mMarks.assign(tree.nodes.size(), true);
+}
+
+template<typename Aggregate>
+void subtree_aggregate<Aggregate>::mark(const tree& tree, int node)
+{
+	// the virtual root does not have a value
+	for (; node > 0 && !mMarks[node]; node = tree.nodes[node].father)
+		mMarks[node] = true;
 }
 
 inline binary_tree::binary_tree(size_t size, int root)
 {
 	nodes = std::vector<binary_tree_node>(size + 1);
 
-	for (size_t index = 0; index < nodes.size(); index++)
+	mTails = std::vector<int>(nodes.size());
+	mValues = std::vector<int>(nodes.size());
+	mMarks = std::vector<bool>(nodes.size(), false);
+	mLinks = std::vector<int>(nodes.size(), 0);
+
+	for (size_t index = 0; index < nodes.size(); index++) {
 		nodes[index].key = static_cast<int>(index);
 
+		mTails[index] = static_cast<int>(index);
+		mValues[index] = static_cast<int>(index);
+	}
+
 	this->root = root;
 }
 
@@ -200,10 +799,10 @@ inline void binary_tree::insert(int father, int left_child, int right_child)
 {
 	shift_to_fit(std::max(father, std::max(left_child, right_child)) + 1);
 
-	nodes[father].key = father;
+	set_key(father, father);
 
-	if (left_child != -1) nodes[left_child].key = left_child;
-	if (right_child != -1) nodes[right_child].key = right_child;
+	if (left_child != -1) set_key(left_child, left_child);
+	if (right_child != -1) set_key(right_child, right_child);
 
 	if (left_child != -1 && left_child == root) root = father;
 	if (right_child != -1 && right_child == root) root = father;
@@ -212,85 +811,258 @@ inline void binary_tree::insert(int father, int left_child, int right_child)
 
 		if (nodes[father].child == 0) {
 			nodes[father].child = left_child;
+
+			add_link(father, left_child);
 		}
 		else {
-			auto child = nodes[father].child;
+			const auto last = last_brother(nodes[father].child);
 
-			while (nodes[child].brother != 0) {
-				child = nodes[child].brother;
-			}
+			nodes[last].brother = left_child;
 
-			nodes[child].brother = left_child;
+			add_link(last, left_child);
 		}
 	}
 
 	if (right_child != -1) {
-		if (nodes[father].brother == 0) {
-			nodes[father].brother = right_child;
-		}
-		else {
-			auto brother = nodes[father].brother;
+		const auto last = last_brother(father);
 
-			while (nodes[brother].brother != 0)
-				brother = nodes[brother].brother;
+		nodes[last].brother = right_child;
 
-			nodes[brother].brother = right_child;
-		}
+		add_link(last, right_child);
 	}
 }
 
-inline void binary_tree::print()
+inline void binary_tree::insert_many(const std::vector<std::pair<int, int>>& edges)
 {
-	int output = 0;
+	auto size = 0;
+
+	for (const auto& edge : edges) size = std::max(size, std::max(edge.first, edge.second));
 
-	search(root, output);
+	// grow once, so insert does not push the nodes one by one
+	shift_to_fit(static_cast<size_t>(size) + 1);
 
-	std::cout << output << std::endl;
+	for (const auto& edge : edges) insert(edge.first, edge.second, -1);
 }
 
-inline auto binary_tree::to_tree() -> std::shared_ptr<tree>
+inline void binary_tree::print()
 {
-	auto tree = std::make_shared<::tree>(nodes.size() - 1, std::vector<int>());
+	std::cout << value(root) << std::endl;
+}
+
+inline void binary_tree::rebuild()
+{
+	mTails.resize(nodes.size());
+	mValues.assign(nodes.size(), 0);
+	mMarks.assign(nodes.size(), true);
+	mLinks.assign(nodes.size(), 0);
+	mMoreLinks.clear();
 
 	for (size_t index = 0; index < nodes.size(); index++)
-		tree->nodes[index].key = nodes[index].key;
+		mTails[index] = static_cast<int>(index);
 
-	std::vector<bool> is_root(nodes.size(), true);
+	// 0 indicate the empty node, so it is never marked and the links of node 0 are ignored
+	mMarks[0] = false;
 
 	for (size_t index = 1; index < nodes.size(); index++) {
-		auto child = nodes[index].child;
+		if (nodes[index].child != 0) add_link(static_cast<int>(index), nodes[index].child);
+		if (nodes[index].brother != 0) add_link(static_cast<int>(index), nodes[index].brother);
+	}
+}
+
+inline auto binary_tree::to_tree() -> std::shared_ptr<tree>
+{
+	auto tree = std::make_shared<::tree>(0, std::vector<int>());
+
+	to_tree(*tree);
+
+	return tree;
+}
 
-		while (child != 0) {
-			tree->nodes[index].children.insert(child);
+inline void binary_tree::to_tree(tree& output) const
+{
+	output.nodes.resize(nodes.size());
+
+	for (size_t index = 0; index < nodes.size(); index++) {
+		output.nodes[index].key = nodes[index].key;
+		output.nodes[index].father = -1;
+		output.nodes[index].children.clear();
+	}
+
+	// the children are usually appended in ascending order, so the end of set is a good hint
+	for (size_t index = 1; index < nodes.size(); index++) {
+		auto& children = output.nodes[index].children;
 
-			is_root[child] = false;
+		for (auto child = nodes[index].child; child != 0; child = nodes[child].brother) {
+			children.insert(children.end(), child);
 
-			child = nodes[child].brother;
+			output.nodes[child].father = static_cast<int>(index);
 		}
 	}
 
-	for (size_t index = 1; index < is_root.size(); index++) {
-		if (is_root[index] == false || nodes[index].key == -1) continue;
+	// the nodes without father are roots unless they are removed
+	for (size_t index = 1; index < nodes.size(); index++) {
+		if (output.nodes[index].father != -1 || nodes[index].key == -1) continue;
 
-		tree->nodes[0].children.insert(static_cast<int>(index));
+		output.nodes[0].children.insert(output.nodes[0].children.end(), static_cast<int>(index));
 	}
 
-	return tree;
+	output.rebuild();
+}
+
+template<typename Visitor>
+void binary_tree::preorder(int node, Visitor&& visitor) const
+{
+	std::vector<int> stack = { node };
+
+	while (!stack.empty()) {
+		const auto current = stack.back();
+
+		stack.pop_back();
+
+		if (current == 0) continue;
+
+		visitor(current);
+
+		stack.push_back(nodes[current].brother);
+		stack.push_back(nodes[current].child);
+	}
+}
+
+template<typename Visitor>
+void binary_tree::postorder(int node, Visitor&& visitor) const
+{
+	// the second of pair indicates whether the child and brother of node are pushed
+	std::vector<std::pair<int, bool>> stack = { { node, false } };
+
+	while (!stack.empty()) {
+		const auto current = stack.back();
+
+		stack.pop_back();
+
+		if (current.first == 0) continue;
+
+		if (current.second) {
+			visitor(current.first);
+
+			continue;
+		}
+
+		stack.push_back({ current.first, true });
+		stack.push_back({ nodes[current.first].brother, false });
+		stack.push_back({ nodes[current.first].child, false });
+	}
 }
 
-inline void binary_tree::search(const int node, int& output)
+template<typename Visitor>
+void binary_tree::levelorder(int node, Visitor&& visitor) const
 {
 	if (node == 0) return;
 
-	output = output ^ nodes[node].key;
+	std::vector<int> queue = { node };
 
-	search(nodes[node].child, output);
-	search(nodes[node].brother, output);
+	for (size_t head = 0; head < queue.size(); head++) {
+		visitor(queue[head]);
+
+		if (nodes[queue[head]].child != 0) queue.push_back(nodes[queue[head]].child);
+		if (nodes[queue[head]].brother != 0) queue.push_back(nodes[queue[head]].brother);
+	}
+}
+
+inline int binary_tree::last_brother(int node)
+{
+	auto last = node;
+
+	while (nodes[last].brother != 0)
+		last = mTails[last] != last ? mTails[last] : nodes[last].brother;
+
+	// compress the hints on the walk
+	while (node != last) {
+		const auto next = mTails[node] != node ? mTails[node] : nodes[node].brother;
+
+		mTails[node] = last;
+		node = next;
+	}
+
+	return last;
+}
+
+inline void binary_tree::set_key(int node, int key)
+{
+	if (nodes[node].key == key) return;
+
+	nodes[node].key = key;
+
+	invalidate(node);
+}
+
+inline void binary_tree::add_link(int node, int target)
+{
+	if (mLinks[target] == 0) mLinks[target] = node;
+	else mMoreLinks.insert({ target, node });
+
+	invalidate(node);
+}
+
+inline void binary_tree::invalidate(int node)
+{
+	// the nodes linking to a node twice or more, only used when a node is linked twice
+	std::vector<int> others;
+
+	while (true) {
+		for (; node != 0 && !mMarks[node]; node = mLinks[node]) {
+			mMarks[node] = true;
+
+			const auto range = mMoreLinks.equal_range(node);
+
+			for (auto it = range.first; it != range.second; ++it) others.push_back(it->second);
+		}
+
+		if (others.empty()) return;
+
+		node = others.back();
+
+		others.pop_back();
+	}
+}
+
+inline int binary_tree::value(int node)
+{
+	// the second of pair indicates whether the child and brother of node are pushed
+	std::vector<std::pair<int, bool>> stack = { { node, false } };
+
+	while (!stack.empty()) {
+		const auto current = stack.back();
+
+		stack.pop_back();
+
+		// a node linked twice may be pushed again after it is recomputed
+		if (current.first == 0 || !mMarks[current.first]) continue;
+
+		if (current.second) {
+			const auto& target = nodes[current.first];
+
+			mValues[current.first] = target.key ^ mValues[target.child] ^ mValues[target.brother];
+			mMarks[current.first] = false;
+
+			continue;
+		}
+
+		stack.push_back({ current.first, true });
+		stack.push_back({ nodes[current.first].brother, false });
+		stack.push_back({ nodes[current.first].child, false });
+	}
+
+	return node == 0 ? 0 : mValues[node];
 }
 
 inline void binary_tree::shift_to_fit(size_t target)
 {
 	for (size_t index = nodes.size(); index < target; index++) {
 		nodes.push_back(binary_tree_node(static_cast<int>(index), 0, 0));
+
+		mTails.push_back(static_cast<int>(index));
+		mValues.push_back(static_cast<int>(index));
+		mMarks.push_back(false);
+		mLinks.push_back(0);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "tree.hpp"
+
+/*
+ * ancestor queries of tree, built from one pre-order of the forest under the virtual root
+ * in/size : node is in the subtree of ancestor if in[ancestor] <= in[node] < in[ancestor] + size[ancestor]
+ * table : sparse table of the node with min depth in a range of pre-order, the lca of u and v(in[u] < in[v])
+ * is the father of the node with min depth in (in[u], in[v]]
+ * levels : the nodes of each depth in pre-order, the k-th ancestor is the last node at its depth that is before node
+ * the tree changes only mark the index dirty, it is rebuilt in O(n log n) at the next query.
+ */
+
+class tree_ancestors final : public tree_listener {
+public:
+	// the tree should outlive the index, add it to the listeners of tree to track the changes
+	explicit tree_ancestors(const tree& tree);
+
+	// the depth of root is 0, -1 if node is not in any tree
+	int depth(int node);
+
+	// true if node is in the subtree of ancestor(a node is an ancestor of itself)
+	bool is_ancestor(int ancestor, int node);
+
+	// the lowest common ancestor, 0 if the nodes are in different trees, -1 if any of them is not in tree
+	int lca(int node0, int node1);
+
+	// the k-th ancestor of node, 0 if k is greater than the depth of node, -1 if node is not in tree
+	int kth_ancestor(int node, int k);
+
+	void on_attach(const tree& tree, int node) override;
+
+	void on_detach(const tree& tree, int node, int old_father) override;
+
+	void on_key(const tree& tree, int node, int old_key) override;
+
+	void on_grow(const tree& tree) override;
+
+	void on_reset(const tree& tree) override;
+private:
+	void rebuild();
+
+	// the node with less depth
+	int shallower(int node0, int node1) const;
+private:
+	const tree* mTree;
+
+	bool mValid = false;
+
+	// the virtual root is the first node of pre-order, the depth of it is -1
+	std::vector<int> mOrder;
+	std::vector<int> mIn;
+	std::vector<int> mSize;
+	std::vector<int> mDepth;
+
+	std::vector<std::vector<int>> mTable;
+
+	std::vector<int> mLevels;
+	std::vector<int> mLevelOffsets;
+};
+
+inline tree_ancestors::tree_ancestors(const tree& tree) : mTree(&tree)
+{
+}
+
+inline int tree_ancestors::depth(int node)
+{
+	if (!mValid) rebuild();
+
+	if (node <= 0 || node >= static_cast<int>(mIn.size()) || mIn[node] == -1) return -1;
+
+	return mDepth[node];
+}
+
+inline bool tree_ancestors::is_ancestor(int ancestor, int node)
+{
+	if (depth(ancestor) == -1 || depth(node) == -1) return false;
+
+	return mIn[ancestor] <= mIn[node] && mIn[node] < mIn[ancestor] + mSize[ancestor];
+}
+
+inline int tree_ancestors::lca(int node0, int node1)
+{
+	if (depth(node0) == -1 || depth(node1) == -1) return -1;
+
+	if (node0 == node1) return node0;
+
+	auto left = mIn[node0];
+	auto right = mIn[node1];
+
+	if (left > right) std::swap(left, right);
+
+	// the range (left, right] of pre-order
+	left = left + 1;
+
+	size_t level = 0;
+
+	while ((2 << level) <= right - left + 1) level++;
+
+	const auto node = shallower(mTable[level][left], mTable[level][right - (1 << level) + 1]);
+
+	return mTree->nodes[node].father;
+}
+
+inline int tree_ancestors::kth_ancestor(int node, int k)
+{
+	if (depth(node) == -1) return -1;
+
+	if (k <= 0) return node;
+
+	if (k > mDepth[node]) return 0;
+
+	// the nodes of a depth are sorted by pre-order, the ancestor is the last one that is not after node
+	const auto begin = mLevels.begin() + mLevelOffsets[mDepth[node] - k];
+	const auto end = mLevels.begin() + mLevelOffsets[mDepth[node] - k + 1];
+
+	const auto it = std::upper_bound(begin, end, mIn[node], [&](int in, int level_node) { return in < mIn[level_node]; });
+
+	return *(it - 1);
+}
+
+inline void tree_ancestors::on_attach(const tree&, int)
+{
+	mValid = false;
+}
+
+inline void tree_ancestors::on_detach(const tree&, int, int)
+{
+	mValid = false;
+}
+
+inline void tree_ancestors::on_key(const tree&, int, int)
+{
+}
+
+inline void tree_ancestors::on_grow(const tree&)
+{
+	mValid = false;
+}
+
+inline void tree_ancestors::on_reset(const tree&)
+{
+	mValid = false;
+}
+
+inline void tree_ancestors::rebuild()
+{
+	const auto& nodes = mTree->nodes;
+
+	mOrder.clear();
+	mIn.assign(nodes.size(), -1);
+	mSize.assign(nodes.size(), 1);
+	mDepth.assign(nodes.size(), -1);
+
+	// the father is visited before its children in pre-order
+	mTree->preorder(0, [&](int node) {
+		mIn[node] = static_cast<int>(mOrder.size());
+		mDepth[node] = node == 0 ? -1 : mDepth[nodes[node].father] + 1;
+
+		mOrder.push_back(node);
+	});
+
+	for (auto index = mOrder.size(); index > 1; index--) {
+		const auto node = mOrder[index - 1];
+
+		mSize[nodes[node].father] += mSize[node];
+	}
+
+	const auto count = mOrder.size();
+
+	mTable.resize(1);
+	mTable[0] = mOrder;
+
+	for (size_t level = 1; (size_t(1) << level) <= count; level++) {
+		const auto& last = mTable[level - 1];
+
+		std::vector<int> current(count - (size_t(1) << level) + 1);
+
+		for (size_t index = 0; index < current.size(); index++)
+			current[index] = shallower(last[index], last[index + (size_t(1) << (level - 1))]);
+
+		mTable.push_back(std::move(current));
+	}
+
+	// counting sort of the nodes by depth, the pre-order is kept in each depth
+	mLevelOffsets.assign(nodes.size() + 1, 0);
+
+	for (size_t index = 1; index < count; index++) mLevelOffsets[mDepth[mOrder[index]] + 1]++;
+
+	for (size_t index = 0; index < nodes.size(); index++) mLevelOffsets[index + 1] += mLevelOffsets[index];
+
+	std::vector<int> positions(mLevelOffsets.begin(), mLevelOffsets.end() - 1);
+
+	mLevels.resize(count - 1);
+
+	for (size_t index = 1; index < count; index++)
+		mLevels[positions[mDepth[mOrder[index]]]++] = mOrder[index];
+
+	mValid = true;
+}
+
+inline int tree_ancestors::shallower(int node0, int node1) const
+{
+	return mDepth[node0] <= mDepth[node1] ? node0 : node1;
+}
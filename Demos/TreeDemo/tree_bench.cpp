@@ -0,0 +1,419 @@
+#include "link_cut_tree.hpp"
+#include "flat_forest.hpp"
+#include "tree_ancestors.hpp"
+#include "parallel_forest.hpp"
+#include "tree_commands.hpp"
+
+#define BENCH_UNIT "nodes"
+#include "../bench_common.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <new>
+
+/*
+ * headless benchmark of tree
+ * suite mode times the traversals, conversions, bulk building, children of wide node, ancestor queries and link cut tree.
+ * replay mode runs a script of console commands(see tree_commands.hpp) at full speed.
+ * workload mode generates a script on random, path or star shaped forests and replays it,
+ * and reports ops/s and the bytes allocated per node.
+ */
+
+// the recursive traversal that tree used before, only safe for shallow trees
+void recursive_search(const tree& tree, int node, int& output) {
+	output = output ^ tree.nodes[node].key;
+
+	for (const auto& child : tree.nodes[node].children)
+		recursive_search(tree, child, output);
+}
+
+// the father of node i is i - 1 for path and i / 2 for balanced
+auto make_tree(size_t size, bool path) -> std::shared_ptr<tree> {
+	auto result = std::make_shared<tree>(size, std::vector<int>{ 1 });
+
+	for (size_t index = 2; index <= size; index++)
+		result->insert(static_cast<int>(path ? index - 1 : index / 2), static_cast<int>(index));
+
+	return result;
+}
+
+void bench_traversal(size_t size, bool path) {
+	const auto shape = std::string(path ? "path" : "balanced");
+	const auto forest = make_tree(size, path);
+	const auto binary = forest->to_binary_tree();
+
+	int output = 0;
+
+	report(shape + " tree preorder", size, time_used([&]() {
+		forest->preorder(1, [&](int node) { output = output ^ node; });
+	}));
+
+	report(shape + " tree postorder", size, time_used([&]() {
+		forest->postorder(1, [&](int node) { output = output ^ node; });
+	}));
+
+	report(shape + " tree levelorder", size, time_used([&]() {
+		forest->levelorder(1, [&](int node) { output = output ^ node; });
+	}));
+
+	if (!path) {
+		report(shape + " tree recursive", size, time_used([&]() {
+			recursive_search(*forest, 1, output);
+		}));
+	}
+
+	report(shape + " binary_tree preorder", size, time_used([&]() {
+		binary->preorder(binary->root, [&](int node) { output = output ^ node; });
+	}));
+
+	report(shape + " binary_tree postorder", size, time_used([&]() {
+		binary->postorder(binary->root, [&](int node) { output = output ^ node; });
+	}));
+
+	report(shape + " binary_tree levelorder", size, time_used([&]() {
+		binary->levelorder(binary->root, [&](int node) { output = output ^ node; });
+	}));
+
+	std::cout << "checksum : " << output << std::endl;
+}
+
+// build the balanced shape by inserts and by the counting sort of fathers
+void bench_bulk_build(size_t size) {
+	std::vector<int> fathers(size + 1, 0);
+
+	for (size_t index = 2; index <= size; index++)
+		fathers[index] = static_cast<int>(index / 2);
+
+	report("balanced tree inserts", size, time_used([&]() { make_tree(size, false); }));
+
+	flat_forest forest;
+	tree result(0, std::vector<int>());
+
+	report("balanced flat_forest from fathers", size, time_used([&]() { forest = flat_forest(fathers); }));
+	report("balanced flat_forest to tree", size, time_used([&]() { forest.to_tree(result); }));
+}
+
+// append all nodes to the children of one node
+void bench_wide_insert(size_t size) {
+	std::vector<std::pair<int, int>> edges;
+
+	for (size_t index = 2; index <= size; index++)
+		edges.push_back({ 1, static_cast<int>(index) });
+
+	binary_tree binary(1, 1);
+
+	report("wide binary_tree insert_many", size, time_used([&]() {
+		binary.insert_many(edges);
+	}));
+}
+
+// insert the children of one node in random order, then ask the rank and the i-th of children
+void bench_wide_children(size_t size, size_t queries) {
+	std::vector<int> order;
+
+	for (size_t index = 2; index <= size; index++) order.push_back(static_cast<int>(index));
+
+	std::mt19937 random(5);
+
+	std::shuffle(order.begin(), order.end(), random);
+
+	tree forest(size, std::vector<int>{ 1 });
+
+	report("wide tree random inserts", order.size(), time_used([&]() {
+		for (const auto& node : order) forest.insert(1, node);
+	}));
+
+	const auto& node = forest.nodes[1];
+
+	size_t output = 0;
+
+	report("wide tree children rank/select", queries, time_used([&]() {
+		for (size_t index = 0; index < queries; index++) {
+			const auto position = random() % node.children.size();
+
+			output = output + node.child_rank(node.child_select(position)) - position;
+		}
+	}));
+
+	std::cout << "checksum : " << output << std::endl;
+}
+
+// convert back and forth, the reused buffers are compared with the new objects
+void bench_conversion(size_t size, size_t rounds) {
+	const auto forest = make_tree(size, false);
+
+	int output = 0;
+
+	report("balanced tree <-> binary_tree new objects", size * rounds, time_used([&]() {
+		for (size_t index = 0; index < rounds; index++) {
+			const auto binary = forest->to_binary_tree();
+			const auto result = binary->to_tree();
+
+			output = output ^ result->nodes[size].key;
+		}
+	}));
+
+	binary_tree binary(0, 0);
+	tree result(0, std::vector<int>());
+
+	report("balanced tree <-> binary_tree reused buffers", size * rounds, time_used([&]() {
+		for (size_t index = 0; index < rounds; index++) {
+			forest->to_binary_tree(binary);
+			binary.to_tree(result);
+
+			output = output ^ result.nodes[size].key;
+		}
+	}));
+
+	std::cout << "checksum : " << output << std::endl;
+}
+
+// random lca and ancestor queries, the first query builds the index
+void bench_ancestors(size_t size, size_t queries) {
+	std::mt19937 generator(0);
+	std::uniform_int_distribution<int> distribution(1, static_cast<int>(size));
+
+	const auto forest = make_tree(size, true);
+	const auto ancestors = std::make_shared<tree_ancestors>(*forest);
+
+	forest->add_listener(ancestors);
+
+	int output = 0;
+
+	report("path tree_ancestors build", size, time_used([&]() { output = output ^ ancestors->depth(1); }));
+
+	report("path tree_ancestors lca/is_ancestor/kth_ancestor", queries, time_used([&]() {
+		for (size_t index = 0; index < queries; index++) {
+			const auto node0 = distribution(generator);
+			const auto node1 = distribution(generator);
+
+			output = output ^ ancestors->lca(node0, node1) ^ ancestors->kth_ancestor(node0, node1 % 64);
+
+			if (ancestors->is_ancestor(node0, node1)) output = output + 1;
+		}
+	}));
+
+	std::cout << "checksum : " << output << std::endl;
+}
+
+// the xor of every tree on one thread and on the pool, a tree per 256 nodes
+void bench_parallel(size_t size, size_t grain) {
+	std::vector<int> fathers(size + 1, 0);
+
+	for (size_t index = 1; index <= size; index++)
+		fathers[index] = index % 256 == 1 ? 0 : static_cast<int>(index - 1);
+
+	tree forest(0, std::vector<int>());
+
+	flat_forest(fathers).to_tree(forest);
+
+	work_stealing_pool pool;
+
+	int output = 0;
+
+	report("chains tree postorder xor", size, time_used([&]() {
+		for (const auto& root : forest.nodes[0].children)
+			forest.postorder(root, [&](int node) { output = output ^ forest.nodes[node].key; });
+	}));
+
+	report("chains parallel_aggregate xor(" + std::to_string(pool.size()) + " threads)", size, time_used([&]() {
+		for (const auto& value : parallel_aggregate<xor_aggregate>(forest, pool, grain))
+			output = output ^ value;
+	}));
+
+	std::cout << "checksum : " << output << std::endl;
+}
+
+// move a random subtree under a random node out of it, then ask the root of a random node
+void bench_link_cut(size_t size, size_t operations) {
+	std::mt19937 generator(0);
+	std::uniform_int_distribution<int> distribution(2, static_cast<int>(size));
+
+	auto forest = make_tree(size, true);
+	auto dynamic = link_cut_tree<>(*forest);
+
+	int output = 0;
+
+	report("path link_cut_tree cut/link/find_root", operations, time_used([&]() {
+		for (size_t index = 0; index < operations; index++) {
+			const auto node = distribution(generator);
+			const auto father = distribution(generator);
+
+			dynamic.cut(node);
+
+			if (!dynamic.link(father, node)) dynamic.link(1, node);
+
+			output = output ^ dynamic.find_root(distribution(generator));
+		}
+	}));
+
+	// the baseline replays the first random operations on tree, every operation of tree walks the fathers and
+	// splits the moved subtree from its set, so it costs O(depth + size of subtree) on a path and is capped
+	const auto baseline = std::min<size_t>(operations, 10000);
+
+	const auto name = "path tree link/root(capped to " + std::to_string(baseline) + " of " + std::to_string(operations) + " ops)";
+
+	generator.seed(0);
+
+	report(name, baseline, time_used([&]() {
+		for (size_t index = 0; index < baseline; index++) {
+			const auto node = distribution(generator);
+			const auto father = distribution(generator);
+
+			// tree does not check cycles, so walk the fathers to keep father out of the subtree of node
+			auto ancestor = father;
+
+			while (ancestor > 0 && ancestor != node) ancestor = forest->nodes[ancestor].father;
+
+			forest->link(ancestor == node ? 1 : father, node);
+
+			output = output ^ forest->root(distribution(generator));
+		}
+	}));
+
+	std::cout << "checksum : " << output << std::endl;
+}
+
+// run the commands on a new session, the commands are parsed before
+void replay(const std::string& name, const std::vector<tree_command>& commands) {
+	tree_session session;
+
+	size_t rejected = 0;
+
+	const auto before = allocated_bytes.load();
+
+	const auto seconds = time_used([&]() {
+		for (const auto& command : commands)
+			if (!session.execute(command)) rejected++;
+	});
+
+	const auto bytes = allocated_bytes.load() - before;
+	const auto nodes = session.is_tree_mode() ?
+		(session.current_tree() == nullptr ? 0 : session.current_tree()->nodes.size() - 1) :
+		(session.current_binary_tree() == nullptr ? 0 : session.current_binary_tree()->nodes.size() - 1);
+
+	std::cout << name << " : " << commands.size() << " commands(" << rejected << " rejected), " << seconds << "s, "
+		<< static_cast<double>(commands.size()) / seconds << " ops/s, "
+		<< static_cast<double>(bytes) / std::max<size_t>(nodes, 1) << " bytes allocated per node." << std::endl;
+}
+
+auto read_script(const std::string& file_name) -> std::vector<tree_command> {
+	std::ifstream stream(file_name);
+
+	std::vector<tree_command> commands;
+
+	for (std::string line; std::getline(stream, line);) {
+		const auto command = parse_tree_command(line);
+
+		if (command.type != tree_command_type::invalid) commands.push_back(command);
+	}
+
+	return commands;
+}
+
+// build a forest of the shape, then insert, remove, link and transform at random
+// the commands are generated on a session, so most of them are accepted by the replay
+auto make_workload(const std::string& shape, size_t count, size_t operations) -> std::vector<tree_command> {
+	std::mt19937 generator(0);
+
+	tree_session session;
+
+	std::vector<tree_command> commands;
+
+	const auto add = [&](tree_command_type type, int father, int child) {
+		tree_command command;
+
+		command.type = type;
+		command.arguments[0] = father;
+		command.arguments[1] = child;
+
+		if (session.execute(command)) commands.push_back(command);
+	};
+
+	add(tree_command_type::build_tree, static_cast<int>(count), 0);
+
+	for (size_t index = 2; index <= count; index++) {
+		const auto node = static_cast<int>(index);
+
+		if (shape == "path") add(tree_command_type::link, node - 1, node);
+		if (shape == "star") add(tree_command_type::link, 1, node);
+		if (shape == "random") add(tree_command_type::link, std::uniform_int_distribution<int>(1, node - 1)(generator), node);
+	}
+
+	auto next = static_cast<int>(count) + 1;
+
+	for (size_t index = 0; index < operations; index++) {
+		const auto& forest = *session.current_tree();
+		const auto size = static_cast<int>(forest.nodes.size()) - 1;
+		const auto node = std::uniform_int_distribution<int>(1, size)(generator);
+		const auto type = std::uniform_int_distribution<int>(0, 99)(generator);
+
+		if (type < 40) add(tree_command_type::insert, node, next++);
+		else if (type < 65) add(tree_command_type::remove, forest.nodes[node].father, node);
+		else add(tree_command_type::link, std::uniform_int_distribution<int>(1, size)(generator), node);
+
+		// a transform copies the whole forest twice, so there are ten of them in a workload
+		if ((index + 1) % std::max<size_t>(operations / 10, 1) == 0) {
+			add(tree_command_type::transform, 0, 0);
+			add(tree_command_type::transform, 0, 0);
+		}
+	}
+
+	return commands;
+}
+
+void bench_suite(size_t size) {
+	bench_traversal(size, true);
+	bench_traversal(size, false);
+	bench_bulk_build(size);
+	bench_wide_insert(size);
+	bench_wide_children(size, size * 4);
+	bench_conversion(size, 10);
+	bench_parallel(size, 4096);
+	bench_ancestors(size, size * 4);
+	bench_link_cut(size, size * 4);
+}
+
+// tree_bench [suite size] | [replay file] | [workload shape count operations]
+int main(int argc, char** argv) {
+	const std::string mode = argc >= 2 ? argv[1] : "suite";
+
+	if (mode == "replay" && argc >= 3) {
+		replay(argv[2], read_script(argv[2]));
+
+		return 0;
+	}
+
+	if (mode == "workload") {
+		const std::string shape = argc >= 3 ? argv[2] : "random";
+
+		const size_t count = argc >= 4 ? std::stoul(argv[3]) : 100000;
+		const size_t operations = argc >= 5 ? std::stoul(argv[4]) : count;
+
+		if (shape != "random" && shape != "path" && shape != "star") {
+			std::cout << "the shape should be random, path or star." << std::endl;
+
+			return 1;
+		}
+
+		replay(shape + " workload", make_workload(shape, count, operations));
+
+		return 0;
+	}
+
+	if (mode != "suite") {
+		std::cout << "usage : tree_bench [suite size] | [replay file] | [workload shape count operations]" << std::endl;
+
+		return 1;
+	}
+
+	bench_suite(argc >= 3 ? std::stoul(argv[2]) : 300000);
+
+	return 0;
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "link_cut_tree.hpp"
+
+#include <sstream>
+#include <string>
+
+/*
+ * headless form of the console commands of TreeDemo, the checks of commands are the same as the console
+ * the commands are parsed before they are executed, so a replay only measures the operations of tree.
+ * build tree size | build binary_tree size root | transform | print
+ * insert father node | remove father node | link father root | insert_child father child | insert_brother father child
+ */
+
+enum class tree_command_type : unsigned {
+	invalid,
+	build_tree,
+	build_binary_tree,
+	transform,
+	insert,
+	remove,
+	link,
+	insert_child,
+	insert_brother,
+	print
+};
+
+struct tree_command {
+	tree_command_type type = tree_command_type::invalid;
+
+	int arguments[2] = { 0, 0 };
+};
+
+// the type is invalid if the line is not a command, empty lines and lines start with '#' are invalid too
+inline auto parse_tree_command(const std::string& line) -> tree_command
+{
+	std::istringstream stream(line);
+
+	std::vector<std::string> words;
+
+	for (std::string word; stream >> word;) words.push_back(word);
+
+	tree_command command;
+
+	const auto is_number = [](const std::string& word) {
+		// 9 digits at most, so the number fits in int
+		return !word.empty() && word.size() <= 9 && word.find_first_not_of("0123456789") == std::string::npos;
+	};
+
+	for (size_t index = 1; index < words.size(); index++) {
+		if (words[0] == "build" && index == 1) continue;
+
+		if (!is_number(words[index])) return command;
+	}
+
+	const auto argument = [&](size_t index) { return std::stoi(words[index]); };
+
+	if (words.size() == 3 && words[0] == "build" && words[1] == "tree") {
+		command.type = tree_command_type::build_tree;
+		command.arguments[0] = argument(2);
+	}
+	else if (words.size() == 4 && words[0] == "build" && words[1] == "binary_tree") {
+		command.type = tree_command_type::build_binary_tree;
+		command.arguments[0] = argument(2);
+		command.arguments[1] = argument(3);
+	}
+	else if (words.size() == 1 && words[0] == "transform") command.type = tree_command_type::transform;
+	else if (words.size() == 1 && words[0] == "print") command.type = tree_command_type::print;
+	else if (words.size() == 3) {
+		if (words[0] == "insert") command.type = tree_command_type::insert;
+		if (words[0] == "remove") command.type = tree_command_type::remove;
+		if (words[0] == "link") command.type = tree_command_type::link;
+		if (words[0] == "insert_child") command.type = tree_command_type::insert_child;
+		if (words[0] == "insert_brother") command.type = tree_command_type::insert_brother;
+
+		command.arguments[0] = argument(1);
+		command.arguments[1] = argument(2);
+	}
+
+	return command;
+}
+
+// the tree, binary tree and mode of console
+class tree_session {
+public:
+	// return false if the command is rejected, the session is not changed in that case
+	bool execute(const tree_command& command);
+
+	// nullptr if it is not built or transformed
+	auto current_tree() const noexcept -> const std::shared_ptr<tree>& { return mTree; }
+
+	auto current_binary_tree() const noexcept -> const std::shared_ptr<binary_tree>& { return mBinaryTree; }
+
+	bool is_tree_mode() const noexcept { return mTreeMode; }
+private:
+	bool has_tree() const;
+
+	auto size() const -> size_t;
+
+	bool legal_node(int node) const;
+
+	bool in(int node) const;
+private:
+	std::shared_ptr<tree> mTree;
+	std::shared_ptr<binary_tree> mBinaryTree;
+
+	// the same forest as tree, it finds the root of a deep tree in O(log n) to check the cycle of link
+	link_cut_tree<> mForest = link_cut_tree<>(0);
+
+	bool mTreeMode = true;
+};
+
+inline bool tree_session::execute(const tree_command& command)
+{
+	const auto father = command.arguments[0];
+	const auto child = command.arguments[1];
+
+	switch (command.type) {
+	case tree_command_type::build_tree: {
+		std::vector<int> roots(father);
+
+		for (size_t index = 0; index < roots.size(); index++)
+			roots[index] = static_cast<int>(index) + 1;
+
+		mTree = std::make_shared<tree>(roots.size(), roots);
+		mTreeMode = true;
+
+		mForest = link_cut_tree<>(*mTree);
+
+		return true;
+	}
+	case tree_command_type::build_binary_tree: {
+		const auto size_of_tree = father;
+		const auto root_of_tree = child;
+
+		if (root_of_tree > size_of_tree || root_of_tree == 0) return false;
+
+		mBinaryTree = std::make_shared<binary_tree>(size_of_tree, root_of_tree);
+
+		// the same chain of brothers as the console
+		for (int index = 1; index < static_cast<int>(mBinaryTree->nodes.size()); index++) {
+			if (index == root_of_tree) continue;
+
+			if (index + 1 == root_of_tree && root_of_tree != size_of_tree)
+				mBinaryTree->nodes[index].brother = index + 2;
+
+			if (index + 1 != root_of_tree && index != size_of_tree)
+				mBinaryTree->nodes[index].brother = index + 1;
+		}
+
+		mBinaryTree->nodes[root_of_tree].brother = 1;
+		mBinaryTree->rebuild();
+
+		mTreeMode = false;
+
+		return true;
+	}
+	case tree_command_type::transform: {
+		if (!has_tree()) return false;
+
+		// reuse the buffers of the last transform
+		if (mTreeMode) {
+			if (mBinaryTree == nullptr) mBinaryTree = std::make_shared<binary_tree>(0, 0);
+
+			mTree->to_binary_tree(*mBinaryTree);
+		}
+		else {
+			if (mTree == nullptr) mTree = std::make_shared<tree>(0, std::vector<int>());
+
+			mBinaryTree->to_tree(*mTree);
+
+			mForest = link_cut_tree<>(*mTree);
+		}
+
+		mTreeMode = !mTreeMode;
+
+		return true;
+	}
+	case tree_command_type::print: {
+		if (!has_tree()) return false;
+
+		if (mTreeMode) mTree->print();
+		else mBinaryTree->print();
+
+		return true;
+	}
+	case tree_command_type::insert: {
+		if (!mTreeMode || !has_tree() || !legal_node(father)) return false;
+
+		if (!in(father) || in(child)) return false;
+
+		mTree->insert(father, child);
+		mForest.insert(father, child);
+
+		return true;
+	}
+	case tree_command_type::remove: {
+		if (!mTreeMode || !has_tree() || !legal_node(father) || !legal_node(child)) return false;
+
+		if (!in(father) || mTree->nodes[child].father != father) return false;
+
+		// the children of removed node become roots
+		for (const auto& node : mTree->nodes[child].children) mForest.cut(node);
+
+		mForest.cut(child);
+		mTree->remove(father, child);
+
+		return true;
+	}
+	case tree_command_type::link: {
+		if (!mTreeMode || !has_tree() || !legal_node(father) || !legal_node(child)) return false;
+
+		if (mTree->nodes[child].father != 0) return false;
+
+		// the console does not check the cycle, the replay does since the scripts may be generated
+		if (!mForest.link(father, child)) return false;
+
+		mTree->link(father, child);
+
+		return true;
+	}
+	case tree_command_type::insert_child: {
+		if (mTreeMode || !has_tree() || !legal_node(father) || !legal_node(child)) return false;
+
+		if (mBinaryTree->nodes[father].child != 0) return false;
+
+		mBinaryTree->insert(father, child, -1);
+
+		return true;
+	}
+	case tree_command_type::insert_brother: {
+		if (mTreeMode || !has_tree() || !legal_node(father) || !legal_node(child)) return false;
+
+		if (mBinaryTree->nodes[father].brother != 0) return false;
+
+		mBinaryTree->insert(father, -1, child);
+
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+inline bool tree_session::has_tree() const
+{
+	return mTreeMode ? mTree != nullptr : mBinaryTree != nullptr;
+}
+
+inline auto tree_session::size() const -> size_t
+{
+	if (!has_tree()) return 0;
+
+	return mTreeMode ? mTree->nodes.size() - 1 : mBinaryTree->nodes.size() - 1;
+}
+
+inline bool tree_session::legal_node(int node) const
+{
+	return node > 0 && static_cast<size_t>(node) <= size();
+}
+
+inline bool tree_session::in(int node) const
+{
+	return mTree->in(node);
+}
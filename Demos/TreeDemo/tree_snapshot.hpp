@@ -0,0 +1,447 @@
+#pragma once
+
+#include "tree.hpp"
+#include "../file_mapping.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * snapshot of tree or binary tree is a binary file of flat arrays, node 0 is the virtual root(tree) or the empty node(binary tree)
+ * tree : header, fathers[count], offsets[count + 1], children[offsets[count]], deleted[count]
+ * binary tree : header, child[count], brother[count], deleted[count]
+ * the keys of nodes are their indices or -1 if they are removed, so only a deleted flag(1 byte) is stored.
+ * the snapshot classes map the file to memory and read the arrays in place, many processes can share one file.
+ */
+
+struct tree_snapshot_header {
+	char magic[8] = { 'T', 'R', 'E', 'E', 'S', 'N', 'A', 'P' };
+
+	std::uint32_t version = 1;
+
+	// 0 : tree, 1 : binary tree
+	std::uint32_t kind = 0;
+
+	// the number of nodes with node 0
+	std::uint64_t count = 0;
+
+	// the size of children array, only for tree
+	std::uint64_t children = 0;
+
+	// the root of binary tree
+	std::int32_t root = 0;
+	std::uint32_t reserved = 0;
+};
+
+// the arrays of tree snapshot, the pointers are valid while the snapshot is alive
+class tree_snapshot final {
+public:
+	// valid() is false if the file is not a snapshot of tree, or its offsets or ids are out of range
+	explicit tree_snapshot(const std::string& file_name);
+
+	bool valid() const noexcept;
+
+	void print() const;
+
+	int key(int node) const;
+
+	int father(int node) const;
+
+	auto children_begin(int node) const -> const int*;
+
+	auto children_end(int node) const -> const int*;
+
+	// iterative traversal of the subtree of node, visitor(node) is called for each node
+	template<typename Visitor>
+	void preorder(int node, Visitor&& visitor) const;
+
+	// copy the snapshot to a tree, the buffers of output are reused
+	void to_tree(tree& output) const;
+
+	auto size() const noexcept -> size_t;
+private:
+	file_mapping mMapping;
+
+	size_t mCount = 0;
+
+	const int* mFathers = nullptr;
+	const int* mOffsets = nullptr;
+	const int* mChildren = nullptr;
+	const std::uint8_t* mDeleted = nullptr;
+};
+
+class binary_tree_snapshot final {
+public:
+	// valid() is false if the file is not a snapshot of binary tree, or its links are out of range
+	explicit binary_tree_snapshot(const std::string& file_name);
+
+	bool valid() const noexcept;
+
+	void print() const;
+
+	int key(int node) const;
+
+	int child(int node) const;
+
+	int brother(int node) const;
+
+	int root() const noexcept;
+
+	// iterative traversal with child as left and brother as right, visitor(node) is called for each node
+	template<typename Visitor>
+	void preorder(int node, Visitor&& visitor) const;
+
+	// copy the snapshot to a binary tree, the buffers of output are reused
+	void to_binary_tree(binary_tree& output) const;
+
+	auto size() const noexcept -> size_t;
+private:
+	file_mapping mMapping;
+
+	size_t mCount = 0;
+
+	int mRoot = 0;
+
+	const int* mChild = nullptr;
+	const int* mBrother = nullptr;
+	const std::uint8_t* mDeleted = nullptr;
+};
+
+// write the values to stream by chunks to avoid a write call per value
+class snapshot_writer final {
+public:
+	explicit snapshot_writer(std::ofstream& stream) : mStream(stream) { mBuffer.reserve(1 << 16); }
+
+	~snapshot_writer() { flush(); }
+
+	template<typename T>
+	void write(const T& value) {
+		if (mBuffer.size() + sizeof(T) > mBuffer.capacity()) flush();
+
+		const auto offset = mBuffer.size();
+
+		mBuffer.resize(offset + sizeof(T));
+
+		std::memcpy(mBuffer.data() + offset, &value, sizeof(T));
+	}
+
+	void flush() {
+		mStream.write(mBuffer.data(), static_cast<std::streamsize>(mBuffer.size()));
+		mBuffer.clear();
+	}
+private:
+	std::ofstream& mStream;
+
+	std::vector<char> mBuffer;
+};
+
+inline auto save_snapshot(const tree& tree, const std::string& file_name) -> bool
+{
+	std::ofstream stream(file_name, std::ios::binary);
+
+	if (!stream.is_open()) return false;
+
+	tree_snapshot_header header;
+
+	header.kind = 0;
+	header.count = tree.nodes.size();
+
+	for (const auto& node : tree.nodes) header.children = header.children + node.children.size();
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	snapshot_writer writer(stream);
+
+	for (const auto& node : tree.nodes) writer.write<std::int32_t>(node.father);
+
+	std::int32_t offset = 0;
+
+	writer.write(offset);
+
+	for (const auto& node : tree.nodes) writer.write<std::int32_t>(offset = offset + static_cast<std::int32_t>(node.children.size()));
+
+	for (const auto& node : tree.nodes) {
+		for (const auto& child : node.children) writer.write<std::int32_t>(child);
+	}
+
+	for (const auto& node : tree.nodes) writer.write<std::uint8_t>(node.key == -1 ? 1 : 0);
+
+	writer.flush();
+
+	return stream.good();
+}
+
+inline auto save_snapshot(const binary_tree& tree, const std::string& file_name) -> bool
+{
+	std::ofstream stream(file_name, std::ios::binary);
+
+	if (!stream.is_open()) return false;
+
+	tree_snapshot_header header;
+
+	header.kind = 1;
+	header.count = tree.nodes.size();
+	header.root = tree.root;
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	snapshot_writer writer(stream);
+
+	for (const auto& node : tree.nodes) writer.write<std::int32_t>(node.child);
+	for (const auto& node : tree.nodes) writer.write<std::int32_t>(node.brother);
+	for (const auto& node : tree.nodes) writer.write<std::uint8_t>(node.key == -1 ? 1 : 0);
+
+	writer.flush();
+
+	return stream.good();
+}
+
+// return nullptr if the file is not a snapshot of kind, the size of arrays is checked by the caller
+inline auto read_snapshot_header(const file_mapping& mapping, std::uint32_t kind) -> const tree_snapshot_header*
+{
+	if (mapping.data() == nullptr || mapping.size() < sizeof(tree_snapshot_header)) return nullptr;
+
+	const tree_snapshot_header expected;
+
+	// the mapping is aligned to page, so the header can be read in place
+	const auto header = reinterpret_cast<const tree_snapshot_header*>(mapping.data());
+
+	if (std::memcmp(header->magic, expected.magic, sizeof(expected.magic)) != 0) return nullptr;
+
+	if (header->version != expected.version || header->kind != kind || header->count == 0) return nullptr;
+
+	return header;
+}
+
+// true if every id of [ids, ids + length) is in [lower, count), so a corrupt file can not be read out of bounds
+inline bool snapshot_ids_in_range(const int* ids, size_t length, int lower, size_t count)
+{
+	for (size_t index = 0; index < length; index++) {
+		if (ids[index] < lower || ids[index] >= static_cast<int>(count)) return false;
+	}
+
+	return true;
+}
+
+inline tree_snapshot::tree_snapshot(const std::string& file_name) : mMapping(file_name, mapping_mode::shared)
+{
+	const auto header = read_snapshot_header(mMapping, 0);
+
+	if (header == nullptr) return;
+
+	const auto count = static_cast<size_t>(header->count);
+	const auto children = static_cast<size_t>(header->children);
+
+	if (mMapping.size() != sizeof(tree_snapshot_header) + (count * 2 + 1 + children) * sizeof(int) + count) return;
+
+	const auto arrays = reinterpret_cast<const int*>(mMapping.data() + sizeof(tree_snapshot_header));
+
+	const auto fathers = arrays;
+	const auto offsets = fathers + count;
+	const auto children_array = offsets + count + 1;
+
+	// the ranges of children should be ordered and cover the children array, the ids should be nodes
+	if (offsets[0] != 0 || offsets[count] != static_cast<int>(children)) return;
+
+	for (size_t index = 0; index < count; index++) {
+		if (offsets[index] > offsets[index + 1]) return;
+	}
+
+	if (!snapshot_ids_in_range(fathers, count, -1, count)) return;
+	if (!snapshot_ids_in_range(children_array, children, 1, count)) return;
+
+	mFathers = fathers;
+	mOffsets = offsets;
+	mChildren = children_array;
+	mDeleted = reinterpret_cast<const std::uint8_t*>(mChildren + children);
+
+	mCount = count;
+}
+
+inline bool tree_snapshot::valid() const noexcept
+{
+	return mCount != 0;
+}
+
+inline void tree_snapshot::print() const
+{
+	for (auto root = children_begin(0); root != children_end(0); ++root) {
+		int output = 0;
+
+		preorder(*root, [&](int node) { output = output ^ key(node); });
+
+		std::cout << output << " ";
+	}
+
+	std::cout << std::endl;
+}
+
+inline int tree_snapshot::key(int node) const
+{
+	return mDeleted[node] != 0 ? -1 : node;
+}
+
+inline int tree_snapshot::father(int node) const
+{
+	return mFathers[node];
+}
+
+inline auto tree_snapshot::children_begin(int node) const -> const int*
+{
+	return mChildren + mOffsets[node];
+}
+
+inline auto tree_snapshot::children_end(int node) const -> const int*
+{
+	return mChildren + mOffsets[node + 1];
+}
+
+template<typename Visitor>
+void tree_snapshot::preorder(int node, Visitor&& visitor) const
+{
+	// the ranges of children that are not visited
+	std::vector<std::pair<const int*, const int*>> stack;
+
+	visitor(node);
+
+	stack.push_back({ children_begin(node), children_end(node) });
+
+	while (!stack.empty()) {
+		auto& range = stack.back();
+
+		if (range.first == range.second) {
+			stack.pop_back();
+
+			continue;
+		}
+
+		const auto current = *range.first++;
+
+		visitor(current);
+
+		stack.push_back({ children_begin(current), children_end(current) });
+	}
+}
+
+inline void tree_snapshot::to_tree(tree& output) const
+{
+	output.nodes.resize(mCount);
+
+	for (size_t index = 0; index < mCount; index++) {
+		auto& node = output.nodes[index];
+
+		node.key = key(static_cast<int>(index));
+		node.children.clear();
+
+		// the children are sorted, so hint the end of set to insert in O(1)
+		for (auto child = children_begin(static_cast<int>(index)); child != children_end(static_cast<int>(index)); ++child)
+			node.children.insert(node.children.end(), *child);
+	}
+
+	output.rebuild();
+}
+
+inline auto tree_snapshot::size() const noexcept -> size_t
+{
+	return mCount == 0 ? 0 : mCount - 1;
+}
+
+inline binary_tree_snapshot::binary_tree_snapshot(const std::string& file_name) : mMapping(file_name, mapping_mode::shared)
+{
+	const auto header = read_snapshot_header(mMapping, 1);
+
+	if (header == nullptr) return;
+
+	const auto count = static_cast<size_t>(header->count);
+
+	if (mMapping.size() != sizeof(tree_snapshot_header) + count * 2 * sizeof(int) + count) return;
+
+	const auto arrays = reinterpret_cast<const int*>(mMapping.data() + sizeof(tree_snapshot_header));
+
+	// 0 is the empty node, so every link and the root should be in [0, count)
+	if (header->root < 0 || header->root >= static_cast<std::int64_t>(count)) return;
+
+	if (!snapshot_ids_in_range(arrays, count * 2, 0, count)) return;
+
+	mChild = arrays;
+	mBrother = mChild + count;
+	mDeleted = reinterpret_cast<const std::uint8_t*>(mBrother + count);
+
+	mRoot = header->root;
+	mCount = count;
+}
+
+inline bool binary_tree_snapshot::valid() const noexcept
+{
+	return mCount != 0;
+}
+
+inline void binary_tree_snapshot::print() const
+{
+	int output = 0;
+
+	if (mRoot != 0) preorder(mRoot, [&](int node) { output = output ^ key(node); });
+
+	std::cout << output << std::endl;
+}
+
+inline int binary_tree_snapshot::key(int node) const
+{
+	return mDeleted[node] != 0 ? -1 : node;
+}
+
+inline int binary_tree_snapshot::child(int node) const
+{
+	return mChild[node];
+}
+
+inline int binary_tree_snapshot::brother(int node) const
+{
+	return mBrother[node];
+}
+
+inline int binary_tree_snapshot::root() const noexcept
+{
+	return mRoot;
+}
+
+template<typename Visitor>
+void binary_tree_snapshot::preorder(int node, Visitor&& visitor) const
+{
+	std::vector<int> stack = { node };
+
+	while (!stack.empty()) {
+		const auto current = stack.back();
+
+		stack.pop_back();
+
+		if (current == 0) continue;
+
+		visitor(current);
+
+		stack.push_back(mBrother[current]);
+		stack.push_back(mChild[current]);
+	}
+}
+
+inline void binary_tree_snapshot::to_binary_tree(binary_tree& output) const
+{
+	output.nodes.resize(mCount);
+	output.root = mRoot;
+
+	for (size_t index = 0; index < mCount; index++) {
+		output.nodes[index].key = key(static_cast<int>(index));
+		output.nodes[index].child = mChild[index];
+		output.nodes[index].brother = mBrother[index];
+	}
+
+	output.rebuild();
+}
+
+inline auto binary_tree_snapshot::size() const noexcept -> size_t
+{
+	return mCount == 0 ? 0 : mCount - 1;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <iostream>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <new>
+
+/*
+ * the timing, the report and the counting allocator shared by the headless benchmarks of the demos
+ * it replaces the global operator new and delete, so it should be included by exactly one translation unit of a tool
+ * define BENCH_UNIT before including it to name the items that are counted by report("ops" by default)
+ */
+
+#ifndef BENCH_UNIT
+#define BENCH_UNIT "ops"
+#endif
+
+using time_clock = std::chrono::high_resolution_clock;
+
+template <typename Function>
+double time_used(const Function& function) {
+	const auto start = time_clock::now();
+	function();
+	const auto end = time_clock::now();
+
+	return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+}
+
+void report(const std::string& name, size_t count, double seconds) {
+	std::cout << name << " : " << seconds << "s, " << static_cast<double>(count) / seconds << " " BENCH_UNIT "/s." << std::endl;
+}
+
+// the bytes allocated by operator new, used to measure the memory per element
+std::atomic<size_t> allocated_bytes(0);
+
+void* counted_allocate(size_t size) {
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (const auto memory = std::malloc(size == 0 ? 1 : size)) return memory;
+
+	throw std::bad_alloc();
+}
+
+// every form of new and delete is replaced, so each pointer is freed by the pair of its allocation
+void* operator new(size_t size) { return counted_allocate(size); }
+
+void* operator new[](size_t size) { return counted_allocate(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete[](void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * read-only memory map of a whole file, shared by the snapshots of SkipListDemo and TreeDemo
+ * sequential : the file is read once from the begin to the end(loading a snapshot), the pages are private to process
+ * shared : the file is read in place at random, the pages are shared with the other processes that map the same file
+ */
+
+enum class mapping_mode : unsigned {
+	sequential = 0,
+	shared = 1
+};
+
+class file_mapping final {
+public:
+	file_mapping(const std::string& file_name, mapping_mode mode);
+
+	~file_mapping();
+
+	file_mapping(const file_mapping&) = delete;
+
+	file_mapping& operator=(const file_mapping&) = delete;
+
+	auto data() const noexcept -> const char* { return mData; }
+
+	auto size() const noexcept -> size_t { return mSize; }
+private:
+	const char* mData = nullptr;
+
+	size_t mSize = 0;
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+#endif
+};
+
+inline file_mapping::file_mapping(const std::string& file_name, mapping_mode mode)
+{
+#ifdef _WIN32
+	mFile = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		mode == mapping_mode::sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (mFile == INVALID_HANDLE_VALUE) return;
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0) return;
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mMapping == nullptr) return;
+
+	mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	mSize = mData == nullptr ? 0 : static_cast<size_t>(size.QuadPart);
+#else
+	const auto file = open(file_name.c_str(), O_RDONLY);
+
+	if (file == -1) return;
+
+	struct stat status;
+
+	if (fstat(file, &status) == 0 && status.st_size > 0) {
+		const auto memory = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ,
+			mode == mapping_mode::shared ? MAP_SHARED : MAP_PRIVATE, file, 0);
+
+		if (memory != MAP_FAILED) {
+			if (mode == mapping_mode::sequential) madvise(memory, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+			mData = static_cast<const char*>(memory);
+			mSize = static_cast<size_t>(status.st_size);
+		}
+	}
+
+	close(file);
+#endif
+}
+
+inline file_mapping::~file_mapping()
+{
+#ifdef _WIN32
+	if (mData != nullptr) UnmapViewOfFile(mData);
+	if (mMapping != nullptr) CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+#else
+	if (mData != nullptr) munmap(const_cast<char*>(mData), mSize);
+#endif
+}